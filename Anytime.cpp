@@ -0,0 +1,236 @@
+#include "Anytime.h"
+
+namespace
+{
+    typedef Piezas::Geometry Geometry;
+
+    // Scores of a position for the player to move. The scores of unfinished
+    // positions lie strictly between LOSS and WIN.
+    const int WIN = 100;
+    const int TIE = 0;
+    const int LOSS = -100;
+
+    // The depth stored for a value which did not hit the depth limit, and
+    // so holds for a search of any depth.
+    const unsigned char SOLVED_DEPTH = 255;
+
+    // Positions between two looks at the clock.
+    const std::uint64_t CLOCK_INTERVAL = 64;
+
+    // Tells the hash of a position reached by a pass from the same position
+    // reached otherwise.
+    const std::uint64_t PASSED_KEY = 0xD1B54A32D192ED03ull;
+}
+
+const int AnytimePlayer::MAX_PLY;
+
+/**
+ * Constructor sets up a transposition table with 2^tableBits entries.
+**/
+AnytimePlayer::AnytimePlayer(int tableBits)
+    : nodes(0), timed(false), stopped(false), reachedLimit(false), followingPv(false), previousPvLength(0)
+{
+    if (tableBits < 1)
+        tableBits = 1;
+    if (tableBits > 30)
+        tableBits = 30;
+
+    table.resize(std::size_t(1) << tableBits);
+    tableShift = 64 - tableBits;
+    clear();
+}
+
+/**
+ * Forgets every position in the transposition table.
+**/
+void AnytimePlayer::clear()
+{
+    const Entry empty = { 0, 0, 0, EMPTY, -1 };
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        table[i] = empty;
+    }
+}
+
+/**
+ * Searches the given position, as if the previous move was not a pass,
+ * and answers within "deadline" of the call, give or take the time of
+ * a few dozen positions. The one-move search always finishes, so a
+ * game which is not over always gets a column.
+**/
+AnytimePlayer::Result AnytimePlayer::bestMove(const Piezas &game, Deadline deadline)
+{
+    const Clock::time_point start = Clock::now();
+    stopAt = start + deadline;
+    nodes = 0;
+    previousPvLength = 0;
+    position = game;
+
+    Result result = { -1, TIE, 0, game.gameState(), 0, 0 };
+    for (int depth = 1; depth <= MAX_PLY && result.outcome == Invalid; ++depth) {
+        timed = depth > 1;
+        stopped = false;
+        reachedLimit = false;
+        followingPv = true;
+        const int score = search(0, depth, false, LOSS - 1, WIN + 1);
+        if (stopped)
+            break;
+
+        result.bestColumn = pv[0][0];
+        result.score = score;
+        result.depth = depth;
+        previousPvLength = pvLength[0];
+        for (int ply = 0; ply < previousPvLength; ++ply) {
+            previousPv[ply] = pv[0][ply];
+        }
+
+        if (!reachedLimit) {
+            const Piece mover = game.currentTurn();
+            const Piece other = (mover == X) ? O : X;
+            result.outcome = (score == WIN) ? mover : (score == LOSS) ? other : Blank;
+        } else if (Clock::now() >= stopAt) {
+            break;
+        }
+    }
+
+    result.nodes = nodes;
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+/**
+ * Returns the score of the position for the player to move, searching
+ * "depth" moves deep. "passed" tells whether the previous move was a
+ * pass. Returns 0 at once when the time is up.
+**/
+int AnytimePlayer::search(int ply, int depth, bool passed, int alpha, int beta)
+{
+    ++nodes;
+    pvLength[ply] = ply;
+    if (timed && (nodes % CLOCK_INTERVAL) == 0 && Clock::now() >= stopAt)
+        stopped = true;
+    if (stopped)
+        return 0;
+
+    const Piece winner = position.gameState();
+    if (winner != Invalid) {
+        if (winner == Blank)
+            return TIE;
+        return (winner == position.currentTurn()) ? WIN : LOSS;
+    }
+    if (depth == 0) {
+        reachedLimit = true;
+        return evaluate();
+    }
+
+    // A stored value searched at least as deep answers the question, except
+    // at the root, which needs its principal variation. Otherwise it still
+    // tells which column to try first.
+    const std::uint64_t position_key = position.hash() ^ (passed ? PASSED_KEY : 0);
+    Entry &entry = table[position_key >> tableShift];
+    int stored_column = -1;
+    if (entry.bound != EMPTY && entry.key == position_key) {
+        stored_column = entry.bestColumn;
+        const bool usable = ply > 0 && entry.depth >= depth
+                         && (entry.bound == EXACT
+                             || (entry.bound == LOWER && entry.value >= beta)
+                             || (entry.bound == UPPER && entry.value <= alpha));
+        if (usable) {
+            if (entry.depth != SOLVED_DEPTH)
+                reachedLimit = true;
+            return entry.value;
+        }
+    }
+
+    // The previous principal variation first, then the stored column, then
+    // the middle columns before the outer ones.
+    const bool on_pv = followingPv && ply < previousPvLength;
+    int columns[BOARD_COLS + 2];
+    int count = 0;
+    if (on_pv)
+        columns[count++] = previousPv[ply];
+    if (stored_column >= 0)
+        columns[count++] = stored_column;
+    for (int i = 0; i < BOARD_COLS; ++i) {
+        columns[count++] = Geometry::orderedColumn(i);
+    }
+
+    const bool outer_limit = reachedLimit;
+    reachedLimit = false;
+    const int original_alpha = alpha;
+    int best = LOSS - 1;
+    int best_column = -1;
+    unsigned int tried = 0;
+    bool tried_pass = false;
+
+    for (int i = 0; i < count && alpha < beta; ++i) {
+        const int column = columns[i];
+        if ((tried >> column) & 1)
+            continue;
+        tried |= 1u << column;
+
+        const Piezas::Move move = position.makeMove(column);
+        pvLength[ply + 1] = ply + 1;
+        followingPv = on_pv && i == 0;
+        int value = TIE;
+        if (move.piece == Blank) {
+            // Every full column is the same pass, so only try one of them. A
+            // pass answering a pass repeats the position, which is a tie.
+            if (tried_pass) {
+                position.unmakeMove(move);
+                continue;
+            }
+            tried_pass = true;
+            if (!passed)
+                value = -search(ply + 1, depth - 1, true, -beta, -alpha);
+        } else {
+            value = -search(ply + 1, depth - 1, false, -beta, -alpha);
+        }
+        followingPv = false;
+        position.unmakeMove(move);
+        if (stopped)
+            return 0;
+
+        if (value > best) {
+            best = value;
+            best_column = column;
+        }
+        if (value > alpha) {
+            alpha = value;
+            pv[ply][ply] = static_cast<signed char>(column);
+            for (int next = ply + 1; next < pvLength[ply + 1]; ++next) {
+                pv[ply][next] = pv[ply + 1][next];
+            }
+            pvLength[ply] = pvLength[ply + 1];
+        }
+    }
+
+    const bool hit_limit = reachedLimit;
+    reachedLimit = outer_limit || hit_limit;
+
+    entry.key = position_key;
+    entry.value = static_cast<std::int16_t>(best);
+    entry.depth = hit_limit ? static_cast<unsigned char>(depth) : SOLVED_DEPTH;
+    entry.bestColumn = static_cast<signed char>(best_column);
+    if (best <= original_alpha) {
+        entry.bound = UPPER;
+    } else if (best >= beta) {
+        entry.bound = LOWER;
+    } else {
+        entry.bound = EXACT;
+    }
+
+    return best;
+}
+
+/**
+ * Returns the score of an unfinished position for the player to move.
+**/
+int AnytimePlayer::evaluate() const
+{
+    // A full board goes to the longer line, so the player whose longest line
+    // is longer so far is ahead.
+    const Piezas::Mask xs = position.xMask();
+    const Piezas::Mask os = static_cast<Piezas::Mask>(position.occupiedMask() & ~xs);
+    const int lead = Geometry::longestLine(xs) - Geometry::longestLine(os);
+    return (position.currentTurn() == X) ? lead : -lead;
+}
@@ -0,0 +1,136 @@
+#ifndef _ANYTIME_H_
+#define _ANYTIME_H_
+#include "Piezas.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Picks moves within a hard time limit by iterative deepening: it searches
+ * the position one move deep, then two, and so on with negamax and
+ * alpha-beta pruning, until the time runs out or a search reaches the end
+ * of every line. The answer is the best column of the deepest search which
+ * finished. A search which runs out of time part way is thrown away.
+ *
+ * Positions at the depth limit are scored by the difference between the
+ * longest lines of the two players, the lines which decide a full board.
+ * Each search tries the principal variation of the search before it first,
+ * then the best column the transposition table remembers, then the columns
+ * in Geometry::orderedColumn order. The moves are the columns of the board
+ * and a pass, exactly as in Solver.
+ *
+ * The transposition table and the principal variations are allocated once
+ * by the constructor. The table is kept from one bestMove to the next, so
+ * the positions of one game get cheaper to search as it goes on, and
+ * searching allocates no memory.
+**/
+class AnytimePlayer
+{
+  public:
+  	typedef std::chrono::nanoseconds Deadline;
+
+  	// The most moves a line can have: a pass never follows a pass.
+  	static const int MAX_PLY = 2 * Piezas::Geometry::CELLS + 2;
+
+  	/**
+  	 * What a search found.
+  	**/
+  	struct Result
+  	{
+  	  	// The column to drop into, or -1 if the game is already over.
+  	  	int bestColumn;
+  	  	// The score of the deepest finished search for the player to move,
+  	  	// and how many moves deep it was.
+  	  	int score;
+  	  	int depth;
+  	  	// The winner with perfect play, or Blank for a tie, if that search
+  	  	// reached the end of every line; Invalid otherwise.
+  	  	Piece outcome;
+  	  	// The number of positions searched, and how long it all took.
+  	  	std::uint64_t nodes;
+  	  	double seconds;
+
+  	  	double nodesPerSecond() const { return seconds > 0 ? nodes / seconds : 0; }
+  	};
+
+  	/**
+  	 * Constructor sets up a transposition table with 2^tableBits entries.
+  	**/
+  	explicit AnytimePlayer(int tableBits = 20);
+
+  	/**
+  	 * Searches the given position, as if the previous move was not a pass,
+  	 * and answers within "deadline" of the call, give or take the time of
+  	 * a few dozen positions. The one-move search always finishes, so a
+  	 * game which is not over always gets a column.
+  	**/
+  	Result bestMove(const Piezas &game, Deadline deadline);
+
+  	/**
+  	 * Forgets every position in the transposition table.
+  	**/
+  	void clear();
+
+  private:
+  	typedef std::chrono::steady_clock Clock;
+
+  	// Whether a stored value is exact, or only a lower or upper bound
+  	// because the search of that position was cut off.
+  	enum Bound
+  	{
+  	  	EMPTY = 0,
+  	  	EXACT,
+  	  	LOWER,
+  	  	UPPER
+  	};
+
+  	struct Entry
+  	{
+  	  	std::uint64_t key;
+  	  	std::int16_t value;
+  	  	// How many moves deep the value was searched, or SOLVED_DEPTH if the
+  	  	// search reached the end of every line.
+  	  	unsigned char depth;
+  	  	unsigned char bound;
+  	  	signed char bestColumn;
+  	};
+
+  	std::vector<Entry> table;
+  	int tableShift;
+
+  	// The position being searched, with its moves made and taken back.
+  	Piezas position;
+  	std::uint64_t nodes;
+  	Clock::time_point stopAt;
+  	// Whether the search may stop for time, and whether it has.
+  	bool timed;
+  	bool stopped;
+  	// Whether the current subtree hit the depth limit anywhere.
+  	bool reachedLimit;
+  	// Whether the current node lies on the previous principal variation.
+  	bool followingPv;
+
+  	// The principal variation of every ply, found by the running search,
+  	// and the one of the last finished search.
+  	signed char pv[MAX_PLY + 1][MAX_PLY + 1];
+  	int pvLength[MAX_PLY + 1];
+  	signed char previousPv[MAX_PLY + 1];
+  	int previousPvLength;
+
+  	/**
+  	 * Returns the score of the position for the player to move, searching
+  	 * "depth" moves deep. "passed" tells whether the previous move was a
+  	 * pass. Returns 0 at once when the time is up.
+  	**/
+  	int search(int ply, int depth, bool passed, int alpha, int beta);
+
+  	/**
+  	 * Returns the score of an unfinished position for the player to move.
+  	**/
+  	int evaluate() const;
+
+  	AnytimePlayer(const AnytimePlayer &);
+  	AnytimePlayer &operator=(const AnytimePlayer &);
+};
+
+#endif /*_ANYTIME_H_*/
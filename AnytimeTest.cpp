@@ -0,0 +1,99 @@
+/**
+ * Unit Tests for AnytimePlayer
+**/
+
+#include <gtest/gtest.h>
+#include "Anytime.h"
+#include "Solver.h"
+#include "TestHelpers.h"
+
+namespace
+{
+    const AnytimePlayer::Deadline SECOND = std::chrono::seconds(1);
+
+    // Solves a position reached by a pass. Solver::solve assumes the previous
+    // move was not a pass, so the replies are solved one by one: the player to
+    // move wins if some drop wins, and otherwise passes back, which is a tie.
+    Piece solveAfterPass(Solver &solver, const Piezas &game)
+    {
+        for (int col = 0; col < BOARD_COLS; ++col) {
+            Piezas next = game;
+            if (next.dropPiece(col) != Blank && solver.solve(next).outcome == game.currentTurn())
+                return game.currentTurn();
+        }
+        return Blank;
+    }
+}
+
+
+TEST(AnytimeTest, deep_search_matches_solver)
+{
+    // This test checks that with time to spare the search reaches the end of every
+    // line, finds the outcome the solver finds, and picks a column which keeps it,
+    // including a full column, which passes.
+    Solver solver;
+    AnytimePlayer player(16);
+    unsigned int state = 5;
+    int passes = 0;
+
+    for (int round = 0; round < 60; ++round) {
+        const Piezas game = randomPosition(state, 1 + round % 8);
+        const Piece outcome = solver.solve(game).outcome;
+        const AnytimePlayer::Result result = player.bestMove(game, SECOND);
+        ASSERT_EQ(result.outcome, outcome);
+        if (game.gameState() != Invalid) {
+            ASSERT_EQ(result.bestColumn, -1);
+            continue;
+        }
+
+        ASSERT_GE(result.bestColumn, 0);
+        ASSERT_LT(result.bestColumn, BOARD_COLS);
+        ASSERT_GE(result.depth, 1);
+        Piezas next = game;
+        if (next.dropPiece(result.bestColumn) == Blank) {
+            ASSERT_EQ(solveAfterPass(solver, next), outcome);
+            ++passes;
+        } else {
+            ASSERT_EQ(solver.solve(next).outcome, outcome);
+        }
+    }
+    ASSERT_GT(passes, 0);
+}
+
+
+TEST(AnytimeTest, deadline_cuts_search_short)
+{
+    // This test checks that a search given no time still finishes the one-move
+    // search and answers with a column, and that a short deadline is kept.
+    AnytimePlayer player;
+    const AnytimePlayer::Result rushed = player.bestMove(Piezas(), AnytimePlayer::Deadline(1));
+    ASSERT_EQ(rushed.depth, 1);
+    ASSERT_EQ(rushed.outcome, Invalid);
+    ASSERT_GE(rushed.bestColumn, 0);
+    ASSERT_LT(rushed.bestColumn, BOARD_COLS);
+
+    player.clear();
+    const AnytimePlayer::Result timed = player.bestMove(Piezas(), std::chrono::microseconds(200));
+    ASSERT_GE(timed.depth, 1);
+    ASSERT_LT(timed.seconds, 0.1);
+    ASSERT_GT(timed.nodesPerSecond(), 0);
+}
+
+
+TEST(AnytimeTest, table_kept_between_moves_without_allocation)
+{
+    // This test checks that searching a position again takes fewer positions
+    // because the table remembers it, and that searching allocates no memory.
+    AnytimePlayer player(16);
+    Piezas game;
+    game.dropPiece(1);
+
+    const long before = allocationCount();
+    const AnytimePlayer::Result first = player.bestMove(game, SECOND);
+    const AnytimePlayer::Result second = player.bestMove(game, SECOND);
+    ASSERT_EQ(allocationCount(), before);
+    ASSERT_NE(first.outcome, Invalid);
+    ASSERT_EQ(second.outcome, first.outcome);
+    ASSERT_EQ(second.bestColumn, first.bestColumn);
+    ASSERT_LT(second.nodes, first.nodes);
+}
@@ -0,0 +1,30 @@
+#include "ConcurrentPiezas.h"
+
+/**
+ * Constructor sets an empty board with X's turn first.
+**/
+ConcurrentPiezas::ConcurrentPiezas()
+    : published(game.encode())
+{
+}
+
+/**
+ * Plays like Piezas::dropPiece and publishes the new position. Only
+ * one thread at a time may play.
+**/
+Piece ConcurrentPiezas::dropPiece(int column)
+{
+    const Piece piece = game.dropPiece(column);
+    published.store(game.encode(), std::memory_order_release);
+    return piece;
+}
+
+/**
+ * Empties the board like Piezas::reset and publishes it. Only one
+ * thread at a time may play.
+**/
+void ConcurrentPiezas::reset()
+{
+    game.reset();
+    published.store(game.encode(), std::memory_order_release);
+}
@@ -0,0 +1,120 @@
+#ifndef _CONCURRENT_PIEZAS_H_
+#define _CONCURRENT_PIEZAS_H_
+#include "Piezas.h"
+#include <atomic>
+#include <cstdint>
+
+/**
+ * A live 3x4 game which one thread plays while any number of other threads
+ * watch it.
+ *
+ * Only one thread at a time may call dropPiece and reset. After every call
+ * the whole position is published as one 32-bit word, Piezas::encode, in
+ * an atomic. Readers load that word and answer from it, so they take no
+ * lock, never wait for the writer or each other, and always see a position
+ * which was actually played, with its board, turn and outcome from the same
+ * moment. A reader which needs several answers about one moment, such as a
+ * whole board, takes a Snapshot and asks it.
+**/
+class ConcurrentPiezas
+{
+  public:
+  	typedef Piezas::Geometry Geometry;
+
+  	/**
+  	 * A position as published: the code of Piezas::encode.
+  	**/
+  	class Snapshot
+  	{
+  	  public:
+  	  	explicit Snapshot(std::uint32_t code) : code(code) {}
+
+  	  	/**
+  	  	 * Returns what Piezas::pieceAt returns for the position.
+  	  	**/
+  	  	Piece pieceAt(int row, int column) const
+  	  	{
+  	  	  	if (row < 0 || row >= BOARD_ROWS || column < 0 || column >= BOARD_COLS)
+  	  	  	  	return Invalid;
+  	  	  	const std::uint32_t bit = Geometry::cellBit(row, column);
+  	  	  	if (!(code & bit))
+  	  	  	  	return Blank;
+  	  	  	return (code & (bit << Geometry::CELLS)) ? X : O;
+  	  	}
+
+  	  	/**
+  	  	 * Returns what Piezas::gameState returns for the position.
+  	  	**/
+  	  	Piece gameState() const
+  	  	{
+  	  	  	if ((code & Geometry::fullBoard()) != Geometry::fullBoard())
+  	  	  	  	return Invalid;
+  	  	  	return PiezasOutcomes<BOARD_ROWS, BOARD_COLS>::fullBoardWinner(
+  	  	  	  	static_cast<Geometry::Mask>((code >> Geometry::CELLS) & Geometry::fullBoard()));
+  	  	}
+
+  	  	/**
+  	  	 * Returns whose turn it is.
+  	  	**/
+  	  	Piece currentTurn() const
+  	  	{
+  	  	  	return ((code >> (2 * Geometry::CELLS)) & 1) ? O : X;
+  	  	}
+
+  	  	/**
+  	  	 * Returns the position as a Piezas.
+  	  	**/
+  	  	Piezas position() const { return Piezas::decode(code); }
+
+  	  	/**
+  	  	 * Returns the code of Piezas::encode for the position.
+  	  	**/
+  	  	std::uint32_t encoded() const { return code; }
+
+  	  private:
+  	  	std::uint32_t code;
+  	};
+
+  	/**
+  	 * Constructor sets an empty board with X's turn first.
+  	**/
+  	ConcurrentPiezas();
+
+  	/**
+  	 * Plays like Piezas::dropPiece and publishes the new position. Only
+  	 * one thread at a time may play.
+  	**/
+  	Piece dropPiece(int column);
+
+  	/**
+  	 * Empties the board like Piezas::reset and publishes it. Only one
+  	 * thread at a time may play.
+  	**/
+  	void reset();
+
+  	/**
+  	 * Returns the position last published. Any thread may read.
+  	**/
+  	Snapshot snapshot() const { return Snapshot(published.load(std::memory_order_acquire)); }
+
+  	/**
+  	 * Return what the Piezas methods of the same names return for the
+  	 * position last published. Any thread may read. Each call reads the
+  	 * position anew, so two calls may see different moves.
+  	**/
+  	Piece pieceAt(int row, int column) const { return snapshot().pieceAt(row, column); }
+  	Piece gameState() const { return snapshot().gameState(); }
+  	Piece currentTurn() const { return snapshot().currentTurn(); }
+
+  private:
+  	static_assert(2 * BOARD_ROWS * BOARD_COLS + 1 <= 32, "the position has to fit in one atomic word");
+
+  	// The game as the writer plays it, which only the writer touches.
+  	Piezas game;
+
+  	// The position for readers, on a cache line of its own so that the
+  	// writer's other stores do not take it away from them.
+  	alignas(64) std::atomic<std::uint32_t> published;
+};
+
+#endif /*_CONCURRENT_PIEZAS_H_*/
@@ -0,0 +1,136 @@
+/**
+ * Unit Tests for ConcurrentPiezas
+**/
+
+#include <gtest/gtest.h>
+#include "ConcurrentPiezas.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // The column of every move the writer of the stress test plays: mostly in
+    // bounds, now and then out of bounds, and into full columns as they come.
+    int nextColumn(unsigned int &state)
+    {
+        state = state * 1103515245 + 12345;
+        return static_cast<int>((state >> 16) % (BOARD_COLS + 1));
+    }
+}
+
+
+TEST(ConcurrentPiezasTest, plays_like_Piezas)
+{
+    // This test plays the same moves on a Piezas and a ConcurrentPiezas and compares
+    // every answer after every move.
+    Piezas game;
+    ConcurrentPiezas live;
+    unsigned int state = 5;
+
+    for (int move = 0; move < 2000; ++move) {
+        const int column = nextColumn(state);
+        ASSERT_EQ(live.dropPiece(column), game.dropPiece(column));
+
+        const ConcurrentPiezas::Snapshot snapshot = live.snapshot();
+        ASSERT_EQ(snapshot.encoded(), game.encode());
+        ASSERT_TRUE(snapshot.position() == game);
+        ASSERT_EQ(live.gameState(), game.gameState());
+        ASSERT_EQ(live.currentTurn(), game.currentTurn());
+        for (int row = -1; row <= BOARD_ROWS; ++row) {
+            for (int col = -1; col <= BOARD_COLS; ++col) {
+                ASSERT_EQ(snapshot.pieceAt(row, col), game.pieceAt(row, col));
+            }
+        }
+
+        if (game.gameState() != Invalid) {
+            game.reset();
+            live.reset();
+            ASSERT_EQ(live.snapshot().encoded(), game.encode());
+        }
+    }
+}
+
+
+TEST(ConcurrentPiezasTest, readers_see_only_played_positions)
+{
+    // This test has one thread play games as fast as it can while three others read
+    // snapshots, and checks that every snapshot is a position the writer published,
+    // with the same answers as that position.
+    const int moves = 200000;
+
+    // Every position the writer will publish, found by playing the same moves first.
+    std::vector<bool> played(std::size_t(1) << (2 * BOARD_ROWS * BOARD_COLS + 1), false);
+    {
+        Piezas game;
+        unsigned int state = 11;
+        played[game.encode()] = true;
+        for (int move = 0; move < moves; ++move) {
+            game.dropPiece(nextColumn(state));
+            played[game.encode()] = true;
+            if (game.gameState() != Invalid) {
+                game.reset();
+                played[game.encode()] = true;
+            }
+        }
+    }
+
+    ConcurrentPiezas live;
+    std::atomic<bool> done(false);
+    std::atomic<long> reads(0);
+    std::atomic<long> errors(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            long count = 0;
+            do {
+                const ConcurrentPiezas::Snapshot snapshot = live.snapshot();
+                const Piezas position = snapshot.position();
+                bool ok = played[snapshot.encoded()] && snapshot.gameState() == position.gameState();
+                for (int row = 0; row < BOARD_ROWS; ++row) {
+                    for (int col = 0; col < BOARD_COLS; ++col) {
+                        ok = ok && snapshot.pieceAt(row, col) == position.pieceAt(row, col);
+                    }
+                }
+                if (!ok)
+                    ++errors;
+                ++count;
+            } while (!done.load());
+            reads += count;
+        });
+    }
+
+    unsigned int state = 11;
+    for (int move = 0; move < moves; ++move) {
+        live.dropPiece(nextColumn(state));
+        if (live.gameState() != Invalid)
+            live.reset();
+    }
+    done = true;
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+
+    ASSERT_EQ(errors.load(), 0);
+    ASSERT_GE(reads.load(), 3);
+}
+
+
+TEST(ConcurrentPiezasTest, read_methods_are_const)
+{
+    // This test reads a full board through const references to every kind of game.
+    Piezas game;
+    ConcurrentPiezas live;
+    for (int i = 0; i < BOARD_ROWS * BOARD_COLS; ++i) {
+        game.dropPiece(i % BOARD_COLS);
+        live.dropPiece(i % BOARD_COLS);
+    }
+
+    const Piezas &const_game = game;
+    const ConcurrentPiezas &const_live = live;
+    ASSERT_EQ(const_game.gameState(), Blank);
+    ASSERT_EQ(const_live.gameState(), Blank);
+    ASSERT_EQ(const_game.pieceAt(2, 3), O);
+    ASSERT_EQ(const_live.pieceAt(2, 3), O);
+}
@@ -0,0 +1,203 @@
+#include "DynamicPiezas.h"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+namespace
+{
+    /**
+     * Scores a full board of a size Piezas is compiled for: the X cells are
+     * packed into the mask of that size, and the winner comes from the same
+     * code BasicPiezas uses. The loop has a fixed trip count, so it is unrolled.
+    **/
+    template <int Rows, int Cols>
+    Piece scoreCompiledSize(const unsigned char *cells, int, int)
+    {
+        typedef typename PiezasGeometry<Rows, Cols>::Mask Mask;
+
+        Mask xs = 0;
+        PIEZAS_UNROLL
+        for (int cell = 0; cell < Rows * Cols; ++cell) {
+            xs |= static_cast<Mask>(cells[cell] == X) << cell;
+        }
+
+        return PiezasOutcomes<Rows, Cols>::fullBoardWinner(xs);
+    }
+
+    /**
+     * Scores a full board of any size by scanning its rows and then its columns
+     * for the longest line of each player.
+    **/
+    Piece scoreAnySize(const unsigned char *cells, int rows, int cols)
+    {
+        // These variables hold the maximum number of continuous squares for each player in the whole board.
+        int O_counter_max = 0;
+        int X_counter_max = 0;
+
+        // First scan the rows, then the columns. A run only continues while the
+        // cell holds the same piece as the previous cell of the line.
+        for (int row = 0; row < rows; ++row) {
+            int counter = 0;
+            for (int col = 0; col < cols; ++col) {
+                const unsigned char piece = cells[row * cols + col];
+                counter = (col > 0 && piece == cells[row * cols + col - 1]) ? counter + 1 : 1;
+                int &counter_max = (piece == X) ? X_counter_max : O_counter_max;
+                if (counter > counter_max)
+                    counter_max = counter;
+            }
+        }
+        for (int col = 0; col < cols; ++col) {
+            int counter = 0;
+            for (int row = 0; row < rows; ++row) {
+                const unsigned char piece = cells[row * cols + col];
+                counter = (row > 0 && piece == cells[(row - 1) * cols + col]) ? counter + 1 : 1;
+                int &counter_max = (piece == X) ? X_counter_max : O_counter_max;
+                if (counter > counter_max)
+                    counter_max = counter;
+            }
+        }
+
+        // Compare the maximum counters to see who won.
+        if (O_counter_max == X_counter_max) {
+            return Blank;
+        } else if (O_counter_max > X_counter_max) {
+            return O;
+        } else {
+            return X;
+        }
+    }
+}
+
+/**
+ * Constructor sets an empty board (3 rows, 4 columns) and
+ * specifies it is X's turn first
+**/
+DynamicPiezas::DynamicPiezas()
+    : DynamicPiezas(BOARD_ROWS, BOARD_COLS)
+{
+}
+
+const int DynamicPiezas::MAX_ROWS;
+const int DynamicPiezas::MAX_COLS;
+
+/**
+ * Constructor sets an empty board of the given size and specifies it is
+ * X's turn first. Throws std::invalid_argument if either size is not
+ * positive, or there are more than MAX_ROWS rows or MAX_COLS columns.
+**/
+DynamicPiezas::DynamicPiezas(int rows, int cols)
+    : rows(rows), cols(cols)
+{
+    if (rows <= 0 || rows > MAX_ROWS)
+        throw std::invalid_argument("DynamicPiezas: rows must be between 1 and MAX_ROWS");
+    if (cols <= 0 || cols > MAX_COLS)
+        throw std::invalid_argument("DynamicPiezas: cols must be between 1 and MAX_COLS");
+
+    // The column heights, then the cells. The bounds above keep this within
+    // an int, but it is worked out in std::size_t and checked all the same.
+    const std::size_t size = static_cast<std::size_t>(cols) * (static_cast<std::size_t>(rows) + 1);
+    if (size / cols != static_cast<std::size_t>(rows) + 1 || size > storage.max_size())
+        throw std::invalid_argument("DynamicPiezas: board too large");
+    storage.resize(size);
+
+    // Route the sizes Piezas is compiled for to their specialized scoring.
+    if (this->rows == 3 && this->cols == 4) {
+        scoreFullBoard = &scoreCompiledSize<3, 4>;
+    } else if (this->rows == 4 && this->cols == 5) {
+        scoreFullBoard = &scoreCompiledSize<4, 5>;
+    } else if (this->rows == 6 && this->cols == 7) {
+        scoreFullBoard = &scoreCompiledSize<6, 7>;
+    } else {
+        scoreFullBoard = &scoreAnySize;
+    }
+
+    // set an empty board
+    reset();
+
+    // specify it is X's turn first
+    turn = X;
+}
+
+/**
+ * Resets each board location to the Blank Piece value, with a board of the
+ * same size as previously specified
+**/
+void DynamicPiezas::reset()
+{
+    // set an empty board
+    std::fill(storage.begin(), storage.begin() + cols, 0);
+    std::fill(storage.begin() + cols, storage.end(), static_cast<unsigned char>(Blank));
+    filled = 0;
+}
+
+/**
+ * Places a piece of the current turn on the board, returns what
+ * piece is placed, and toggles which Piece's turn it is. dropPiece does
+ * NOT allow to place a piece in a location where a column is full.
+ * In that case, placePiece returns Piece Blank value
+ * Out of bounds coordinates return the Piece Invalid value
+ * Trying to drop a piece where it cannot be placed loses the player's turn
+**/
+Piece DynamicPiezas::dropPiece(int column)
+{
+    Piece piece = Blank;
+
+    // Out of bounds coordinates
+    if (column < 0 || column >= cols) {
+        piece = Invalid;
+    // Inside bounds coordinates
+    } else {
+        // The height of the column is the row the piece lands on.
+        const int row = heights()[column];
+
+        if (row < rows) {
+            cells()[row * cols + column] = turn;
+            heights()[column] = row + 1;
+            ++filled;
+            piece = turn;
+        } else {
+            piece = Blank;
+        }
+    }
+
+    // set the turn to the other player
+    turn = (turn == X) ? O : X;
+
+    return piece;
+}
+
+/**
+ * Returns what piece is at the provided coordinates, or Blank if there
+ * are no pieces there, or Invalid if the coordinates are out of bounds
+**/
+Piece DynamicPiezas::pieceAt(int row, int column) const
+{
+    const bool row_invalid = row < 0 || row >= rows;
+    const bool col_invalid = column < 0 || column >= cols;
+
+    if (row_invalid || col_invalid) {
+        return Invalid;
+    } else {
+        // This can return either the piece or a Blank.
+        // By default when the board is cleared, all values are set to Blank.
+        return static_cast<Piece>(cells()[row * cols + column]);
+    }
+}
+
+/**
+ * Returns which Piece has won, if there is a winner, Invalid if the game
+ * is not over, or Blank if the board is filled and no one has won ("tie").
+ * For a game to be over, all locations on the board must be filled with X's
+ * and O's (i.e. no remaining Blank spaces). The winner is which player has
+ * the most adjacent pieces in a single line. Lines can go either vertically
+ * or horizontally. If both X's and O's have the same max number of pieces in a
+ * line, it is a tie.
+**/
+Piece DynamicPiezas::gameState() const
+{
+    // The game is not over while there are any Blank squares.
+    if (filled < rows * cols)
+        return Invalid;
+
+    return scoreFullBoard(cells(), rows, cols);
+}
@@ -0,0 +1,107 @@
+#ifndef _DYNAMIC_PIEZAS_H_
+#define _DYNAMIC_PIEZAS_H_
+#include "Piezas.h"
+#include <climits>
+#include <vector>
+
+/**
+ * Class for representing a Piezas vertical board whose size is chosen at
+ * run time, when the game is created. It plays by the same rules as
+ * BasicPiezas and uses the same board coordinates, [0,col] being the bottom
+ * of column col.
+ *
+ * The board lives in one flat, contiguous buffer: the height of each column
+ * followed by the cells in row-major order, one byte each. On typical board
+ * sizes the whole buffer fits in a single cache line, so pieceAt and
+ * dropPiece touch only that line. Board sizes that Piezas is compiled for
+ * (3x4, 4x5 and 6x7) score full boards with code specialized for the size.
+**/
+class DynamicPiezas
+{
+  private:
+  	int rows;
+  	int cols;
+
+  	// The first "cols" bytes are the number of pieces in each column, and the
+  	// "rows * cols" bytes after them are the cells, holding Piece values.
+  	std::vector<unsigned char> storage;
+  	Piece turn;
+
+  	// The number of pieces on the board, so gameState can tell whether the
+  	// board is full without looking at it.
+  	int filled;
+
+  	// Works out the winner of a full board. Chosen by the constructor
+  	// according to the board size.
+  	Piece (*scoreFullBoard)(const unsigned char *cells, int rows, int cols);
+
+  	unsigned char *heights() { return &storage[0]; }
+  	unsigned char *cells() { return &storage[cols]; }
+  	const unsigned char *cells() const { return &storage[cols]; }
+
+  public:
+  	/**
+     * Constructor sets an empty board (3 rows, 4 columns) and
+     * specifies it is X's turn first
+    **/
+  	DynamicPiezas();
+
+  	// The most rows a board can have, as column heights are kept in one byte.
+  	static const int MAX_ROWS = UCHAR_MAX;
+
+  	// The most columns a board can have, so that the index of every cell,
+  	// and the number of cells, fits in an int.
+  	static const int MAX_COLS = INT_MAX / (MAX_ROWS + 1);
+
+  	/**
+     * Constructor sets an empty board of the given size and specifies it is
+     * X's turn first. Throws std::invalid_argument if either size is not
+     * positive, or there are more than MAX_ROWS rows or MAX_COLS columns.
+    **/
+  	DynamicPiezas(int rows, int cols);
+
+  	/**
+  	 * Returns the number of rows of the board.
+  	**/
+  	int rowCount() const { return rows; }
+
+  	/**
+  	 * Returns the number of columns of the board.
+  	**/
+  	int columnCount() const { return cols; }
+
+  	/**
+     * Resets each board location to the Blank Piece value, with a board of the
+     * same size as previously specified
+    **/
+  	void reset();
+
+  	/**
+  	 * Places a piece of the current turn on the board, returns what
+  	 * piece is placed, and toggles which Piece's turn it is. dropPiece does
+  	 * NOT allow to place a piece in a location where a column is full.
+  	 * In that case, placePiece returns Piece Blank value
+  	 * Out of bounds coordinates return the Piece Invalid value
+     * Trying to drop a piece where it cannot be placed loses the player's turn
+  	**/
+  	Piece dropPiece(int column);
+
+  	/**
+  	 * Returns what piece is at the provided coordinates, or Blank if there
+  	 * are no pieces there, or Invalid if the coordinates are out of bounds
+  	**/
+  	Piece pieceAt(int row, int column) const;
+
+    /**
+     * Returns which Piece has won, if there is a winner, Invalid if the game
+     * is not over, or Blank if the board is filled and no one has won ("tie").
+     * For a game to be over, all locations on the board must be filled with X's
+     * and O's (i.e. no remaining Blank spaces). The winner is which player has
+     * the most adjacent pieces in a single line. Lines can go either vertically
+     * or horizontally. If both X's and O's have the same number of pieces in a
+     * line, it is a tie.
+    **/
+  	Piece gameState() const;
+};
+
+#endif /*_DYNAMIC_PIEZAS_H_*/
@@ -0,0 +1,131 @@
+/**
+ * Unit Tests for DynamicPiezas
+**/
+
+#include <gtest/gtest.h>
+#include "DynamicPiezas.h"
+#include <stdexcept>
+
+namespace
+{
+    // Plays the same pseudo-random moves, including drops into full and invalid
+    // columns, on a DynamicPiezas and on the BasicPiezas of the same size, and
+    // checks that both boards agree after every move.
+    template <int Rows, int Cols>
+    void expectSameAsBasicPiezas(unsigned int seed)
+    {
+        DynamicPiezas dynamic(Rows, Cols);
+        BasicPiezas<Rows, Cols> basic;
+
+        for (int round = 0; round < 200; ++round) {
+            dynamic.reset();
+            basic.reset();
+            Piece winner = Invalid;
+            while (winner == Invalid) {
+                seed = seed * 1103515245 + 12345;
+                const int column = static_cast<int>((seed >> 16) % (Cols + 2)) - 1;
+                ASSERT_EQ(dynamic.dropPiece(column), basic.dropPiece(column));
+                for (int row = 0; row < Rows; ++row) {
+                    for (int col = 0; col < Cols; ++col) {
+                        ASSERT_EQ(dynamic.pieceAt(row, col), basic.pieceAt(row, col));
+                    }
+                }
+                winner = basic.gameState();
+                ASSERT_EQ(dynamic.gameState(), winner);
+            }
+        }
+    }
+}
+
+
+TEST(DynamicPiezasTest, constructor_default_size)
+{
+    // This test checks that the default constructor makes an empty 3 row, 4 column board.
+    DynamicPiezas game;
+
+    ASSERT_EQ(game.rowCount(), BOARD_ROWS);
+    ASSERT_EQ(game.columnCount(), BOARD_COLS);
+    ASSERT_EQ(game.pieceAt(0, 0), Blank);
+    ASSERT_EQ(game.pieceAt(BOARD_ROWS - 1, BOARD_COLS - 1), Blank);
+    ASSERT_EQ(game.pieceAt(BOARD_ROWS, 0), Invalid);
+}
+
+
+TEST(DynamicPiezasTest, constructor_invalid_size)
+{
+    // This test checks that sizes which are not positive, or too large for a
+    // column height or a cell index to hold, are rejected rather than replaced.
+    ASSERT_THROW(DynamicPiezas(0, 4), std::invalid_argument);
+    ASSERT_THROW(DynamicPiezas(3, 0), std::invalid_argument);
+    ASSERT_THROW(DynamicPiezas(-1, -2), std::invalid_argument);
+    ASSERT_THROW(DynamicPiezas(DynamicPiezas::MAX_ROWS + 1, 2), std::invalid_argument);
+    ASSERT_THROW(DynamicPiezas(3, DynamicPiezas::MAX_COLS + 1), std::invalid_argument);
+    ASSERT_THROW(DynamicPiezas(INT_MAX, INT_MAX), std::invalid_argument);
+
+    DynamicPiezas wide(1, 1000);
+    ASSERT_EQ(wide.columnCount(), 1000);
+    ASSERT_EQ(wide.dropPiece(999), X);
+    ASSERT_EQ(wide.pieceAt(0, 999), X);
+}
+
+
+TEST(DynamicPiezasTest, tallest_board)
+{
+    // This test checks that a board of DynamicPiezas::MAX_ROWS rows can be filled
+    // to the top of a column without wrapping the height around or overwriting the
+    // bottom piece.
+    DynamicPiezas game(DynamicPiezas::MAX_ROWS, 2);
+    ASSERT_EQ(game.rowCount(), DynamicPiezas::MAX_ROWS);
+
+    for (int row = 0; row < DynamicPiezas::MAX_ROWS; ++row) {
+        ASSERT_EQ(game.dropPiece(0), (row % 2) ? O : X);
+    }
+    ASSERT_EQ(game.dropPiece(0), Blank);
+    ASSERT_EQ(game.dropPiece(0), Blank);
+    ASSERT_EQ(game.pieceAt(0, 0), X);
+    ASSERT_EQ(game.pieceAt(DynamicPiezas::MAX_ROWS - 1, 0), X);
+    ASSERT_EQ(game.gameState(), Invalid);
+}
+
+
+TEST(DynamicPiezasTest, reset_keeps_size)
+{
+    // This test checks that reset clears a 2 row, 9 column board and keeps its size.
+    DynamicPiezas game(2, 9);
+
+    game.dropPiece(8);
+    game.dropPiece(8);
+    ASSERT_EQ(game.dropPiece(8), Blank);
+    game.reset();
+
+    ASSERT_EQ(game.rowCount(), 2);
+    ASSERT_EQ(game.columnCount(), 9);
+    ASSERT_EQ(game.pieceAt(0, 8), Blank);
+    ASSERT_EQ(game.pieceAt(1, 8), Blank);
+    ASSERT_EQ(game.dropPiece(8), O);
+}
+
+
+TEST(DynamicPiezasTest, matches_BasicPiezas_3x4)
+{
+    expectSameAsBasicPiezas<3, 4>(1);
+}
+
+
+TEST(DynamicPiezasTest, matches_BasicPiezas_4x5)
+{
+    expectSameAsBasicPiezas<4, 5>(2);
+}
+
+
+TEST(DynamicPiezasTest, matches_BasicPiezas_6x7)
+{
+    expectSameAsBasicPiezas<6, 7>(3);
+}
+
+
+TEST(DynamicPiezasTest, matches_BasicPiezas_5x3)
+{
+    // 5x3 is not one of the compiled sizes, so this covers the generic scoring.
+    expectSameAsBasicPiezas<5, 3>(4);
+}
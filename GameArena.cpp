@@ -0,0 +1,241 @@
+#include "GameArena.h"
+
+namespace
+{
+    typedef GameArena::Geometry Geometry;
+    typedef GameArena::Mask Mask;
+
+    /**
+     * Plays one move on the parts of a live game, exactly like
+     * Piezas::dropPiece, and works out the outcome once the board is full.
+    **/
+    inline Piece drop(Mask &occupied, Mask &xs, unsigned char &turn, unsigned char &outcome, int column)
+    {
+        Piece piece = Blank;
+
+        // Out of bounds coordinates
+        if (column < 0 || column >= BOARD_COLS) {
+            piece = Invalid;
+        // Inside bounds coordinates
+        } else {
+            // The lowest free cell of the column is where the piece lands.
+            const Mask free_cells = static_cast<Mask>(~occupied & (Geometry::columnZero() << column));
+
+            if (free_cells != 0) {
+                const Mask landing = static_cast<Mask>(free_cells & (0 - free_cells));
+                occupied |= landing;
+                if (turn == X)
+                    xs |= landing;
+                piece = static_cast<Piece>(turn);
+
+                if (occupied == Geometry::fullBoard())
+                    outcome = PiezasOutcomes<BOARD_ROWS, BOARD_COLS>::fullBoardWinner(xs);
+            } else {
+                piece = Blank;
+            }
+        }
+
+        // set the turn to the other player
+        turn = (turn == X) ? O : X;
+
+        return piece;
+    }
+}
+
+/**
+ * Constructor sets up an empty arena, with room for "capacity" games
+ * before the pools have to grow.
+**/
+GameArena::GameArena(std::size_t capacity)
+{
+    occupied.reserve(capacity);
+    xs.reserve(capacity);
+    turns.reserve(capacity);
+    outcomes.reserve(capacity);
+}
+
+/**
+ * Starts a new game with an empty board and X's turn first, and returns
+ * its slot.
+**/
+int GameArena::create()
+{
+    int slot = 0;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<int>(turns.size());
+        occupied.push_back(0);
+        xs.push_back(0);
+        turns.push_back(X);
+        outcomes.push_back(Invalid);
+    }
+
+    occupied[slot] = 0;
+    xs[slot] = 0;
+    turns[slot] = X;
+    outcomes[slot] = Invalid;
+    return slot;
+}
+
+/**
+ * Ends the game in the given slot, so that create can reuse the slot.
+**/
+void GameArena::destroy(int slot)
+{
+    if (!live(slot))
+        return;
+
+    turns[slot] = FREE;
+    freeSlots.push_back(slot);
+}
+
+/**
+ * Resets each board location of the game to the Blank Piece value. As
+ * with Piezas::reset, the turn is left as it was.
+**/
+void GameArena::reset(int slot)
+{
+    if (!live(slot))
+        return;
+
+    occupied[slot] = 0;
+    xs[slot] = 0;
+    outcomes[slot] = Invalid;
+}
+
+/**
+ * Plays Piezas::dropPiece on the game in the given slot: places a piece
+ * of the current turn, returns what piece is placed, and toggles the
+ * turn. A full column returns Blank and out of bounds coordinates
+ * return Invalid, and either way the player loses the turn.
+**/
+Piece GameArena::dropPiece(int slot, int column)
+{
+    if (!live(slot))
+        return Invalid;
+
+    return drop(occupied[slot], xs[slot], turns[slot], outcomes[slot], column);
+}
+
+/**
+ * Returns what piece is at the provided coordinates of the game, or Blank
+ * if there are no pieces there, or Invalid if the coordinates are out of
+ * bounds.
+**/
+Piece GameArena::pieceAt(int slot, int row, int column) const
+{
+    const bool row_invalid = row < 0 || row >= BOARD_ROWS;
+    const bool col_invalid = column < 0 || column >= BOARD_COLS;
+
+    if (!live(slot) || row_invalid || col_invalid) {
+        return Invalid;
+    } else {
+        const Mask bit = Geometry::cellBit(row, column);
+        if (!(occupied[slot] & bit))
+            return Blank;
+        return (xs[slot] & bit) ? X : O;
+    }
+}
+
+/**
+ * Returns what Piezas::gameState returns for the game: the winner, Blank
+ * for a tie, or Invalid if the board is not full yet.
+**/
+Piece GameArena::gameState(int slot) const
+{
+    if (!live(slot))
+        return Invalid;
+
+    const Piece winner = static_cast<Piece>(outcomes[slot]);
+
+#ifdef PIEZAS_DEBUG_GAMESTATE
+    if (occupied[slot] != Geometry::fullBoard()) {
+        assert(winner == Invalid);
+    } else {
+        assert(winner == Geometry::fullBoardWinner(xs[slot]));
+    }
+#endif
+
+    return winner;
+}
+
+/**
+ * Returns whose turn it is in the game, or Invalid if there is no game.
+**/
+Piece GameArena::currentTurn(int slot) const
+{
+    return live(slot) ? static_cast<Piece>(turns[slot]) : Invalid;
+}
+
+/**
+ * Returns what Piezas::encode returns for the game, which packs its
+ * board and turn into 32 bits. The slot has to hold a live game.
+**/
+std::uint32_t GameArena::encode(int slot) const
+{
+    return std::uint32_t(occupied[slot])
+         | (std::uint32_t(xs[slot]) << Geometry::CELLS)
+         | (std::uint32_t(turns[slot] == O) << (2 * Geometry::CELLS));
+}
+
+/**
+ * Drops a piece into the same column of n games in one pass, as if
+ * dropPiece(slots[i], column) was called for each of them. What each
+ * drop placed is written to placed[i], unless "placed" is null.
+**/
+void GameArena::dropPieces(const int *slots, std::size_t n, int column, Piece *placed)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        const int slot = slots[i];
+        const Piece piece = live(slot) ? drop(occupied[slot], xs[slot], turns[slot], outcomes[slot], column) : Invalid;
+        if (placed)
+            placed[i] = piece;
+    }
+}
+
+/**
+ * Drops a piece into columns[i] of game slots[i], for n games in one pass.
+ * What each drop placed is written to placed[i], unless "placed" is null.
+**/
+void GameArena::dropPieces(const int *slots, const int *columns, std::size_t n, Piece *placed)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        const int slot = slots[i];
+        const Piece piece = live(slot) ? drop(occupied[slot], xs[slot], turns[slot], outcomes[slot], columns[i]) : Invalid;
+        if (placed)
+            placed[i] = piece;
+    }
+}
+
+/**
+ * Writes gameState(slots[i]) to out[i] for n games.
+**/
+void GameArena::gameStates(const int *slots, std::size_t n, Piece *out) const
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = gameState(slots[i]);
+    }
+}
+
+/**
+ * Returns the number of bytes the arena has allocated for its pools.
+**/
+std::size_t GameArena::bytes() const
+{
+    return occupied.capacity() * sizeof(Mask)
+         + xs.capacity() * sizeof(Mask)
+         + turns.capacity() * sizeof(unsigned char)
+         + outcomes.capacity() * sizeof(unsigned char)
+         + freeSlots.capacity() * sizeof(int);
+}
+
+/**
+ * Returns the bytes allocated per live game, counting the capacity of
+ * every pool, or 0 if there are no live games.
+**/
+double GameArena::bytesPerGame() const
+{
+    return size() > 0 ? double(bytes()) / size() : 0;
+}
@@ -0,0 +1,149 @@
+#ifndef _GAME_ARENA_H_
+#define _GAME_ARENA_H_
+#include "Piezas.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Hosts many 3x4 Piezas games at once, for servers with a great number of
+ * live matches. Instead of one Piezas object per game, the arena keeps each
+ * part of the games in its own contiguous pool: the occupied masks, the X
+ * masks, whose turn it is and the outcome of every game, indexed by slot.
+ * A game costs a few bytes, there is no allocation per game, and operations
+ * over many games walk through small dense arrays.
+ *
+ * Slots of finished games are released with destroy and handed out again
+ * by create, most recently released first. Every per-slot operation plays by
+ * the same rules as the same method of Piezas. A slot which does not hold a
+ * live game is treated like out of bounds coordinates: nothing changes and
+ * Invalid is returned.
+**/
+class GameArena
+{
+  public:
+  	typedef Piezas::Geometry Geometry;
+  	typedef Piezas::Mask Mask;
+
+  private:
+  	// The pools, one element per slot. The boards are laid out as in Piezas.
+  	// "turns" holds the Piece to move, or FREE for slots without a game, and
+  	// "outcomes" holds what gameState returns, worked out when the board
+  	// fills up so that reading it is a single load.
+  	std::vector<Mask> occupied;
+  	std::vector<Mask> xs;
+  	std::vector<unsigned char> turns;
+  	std::vector<unsigned char> outcomes;
+
+  	// Released slots, reused from the back.
+  	std::vector<int> freeSlots;
+
+  	static const unsigned char FREE = 0;
+
+  	bool live(int slot) const
+  	{
+  	  	return slot >= 0 && static_cast<std::size_t>(slot) < turns.size() && turns[slot] != FREE;
+  	}
+
+  public:
+  	/**
+  	 * Constructor sets up an empty arena, with room for "capacity" games
+  	 * before the pools have to grow.
+  	**/
+  	explicit GameArena(std::size_t capacity = 0);
+
+  	/**
+  	 * Starts a new game with an empty board and X's turn first, and returns
+  	 * its slot.
+  	**/
+  	int create();
+
+  	/**
+  	 * Ends the game in the given slot, so that create can reuse the slot.
+  	**/
+  	void destroy(int slot);
+
+  	/**
+  	 * Returns whether the given slot holds a live game.
+  	**/
+  	bool isLive(int slot) const { return live(slot); }
+
+  	/**
+  	 * Returns the number of live games.
+  	**/
+  	std::size_t size() const { return turns.size() - freeSlots.size(); }
+
+  	/**
+  	 * Returns the number of slots, live or released.
+  	**/
+  	std::size_t slotCount() const { return turns.size(); }
+
+  	/**
+  	 * Resets each board location of the game to the Blank Piece value. As
+  	 * with Piezas::reset, the turn is left as it was.
+  	**/
+  	void reset(int slot);
+
+  	/**
+  	 * Plays Piezas::dropPiece on the game in the given slot: places a piece
+  	 * of the current turn, returns what piece is placed, and toggles the
+  	 * turn. A full column returns Blank and out of bounds coordinates
+  	 * return Invalid, and either way the player loses the turn.
+  	**/
+  	Piece dropPiece(int slot, int column);
+
+  	/**
+  	 * Returns what piece is at the provided coordinates of the game, or Blank
+  	 * if there are no pieces there, or Invalid if the coordinates are out of
+  	 * bounds.
+  	**/
+  	Piece pieceAt(int slot, int row, int column) const;
+
+  	/**
+  	 * Returns what Piezas::gameState returns for the game: the winner, Blank
+  	 * for a tie, or Invalid if the board is not full yet.
+  	**/
+  	Piece gameState(int slot) const;
+
+  	/**
+  	 * Returns whose turn it is in the game, or Invalid if there is no game.
+  	**/
+  	Piece currentTurn(int slot) const;
+
+  	/**
+  	 * Returns what Piezas::encode returns for the game, which packs its
+  	 * board and turn into 32 bits. The slot has to hold a live game.
+  	**/
+  	std::uint32_t encode(int slot) const;
+
+  	/**
+  	 * Drops a piece into the same column of n games in one pass, as if
+  	 * dropPiece(slots[i], column) was called for each of them. What each
+  	 * drop placed is written to placed[i], unless "placed" is null.
+  	**/
+  	void dropPieces(const int *slots, std::size_t n, int column, Piece *placed);
+
+  	/**
+  	 * Drops a piece into columns[i] of game slots[i], for n games in one pass.
+  	 * What each drop placed is written to placed[i], unless "placed" is null.
+  	**/
+  	void dropPieces(const int *slots, const int *columns, std::size_t n, Piece *placed);
+
+  	/**
+  	 * Writes gameState(slots[i]) to out[i] for n games.
+  	**/
+  	void gameStates(const int *slots, std::size_t n, Piece *out) const;
+
+  	/**
+  	 * Returns the number of bytes the arena has allocated for its pools.
+  	**/
+  	std::size_t bytes() const;
+
+  	/**
+  	 * Returns the bytes allocated per live game, counting the capacity of
+  	 * every pool, or 0 if there are no live games.
+  	**/
+  	double bytesPerGame() const;
+};
+
+#endif /*_GAME_ARENA_H_*/
@@ -0,0 +1,128 @@
+/**
+ * Unit Tests for GameArena
+**/
+
+#include <gtest/gtest.h>
+#include "GameArena.h"
+#include <vector>
+
+TEST(GameArenaTest, games_match_Piezas)
+{
+    // This test plays many pseudo-random games side by side, including out of bounds
+    // drops and drops into full columns, and compares every slot with its own Piezas
+    // after every move.
+    GameArena arena;
+    std::vector<Piezas> games(50);
+    std::vector<int> slots;
+    for (std::size_t i = 0; i < games.size(); ++i) {
+        slots.push_back(arena.create());
+    }
+
+    unsigned int state = 7;
+    for (int move = 0; move < 40; ++move) {
+        for (std::size_t i = 0; i < games.size(); ++i) {
+            state = state * 1103515245 + 12345;
+            const int column = static_cast<int>((state >> 16) % (BOARD_COLS + 2)) - 1;
+            ASSERT_EQ(arena.dropPiece(slots[i], column), games[i].dropPiece(column));
+            ASSERT_EQ(arena.currentTurn(slots[i]), games[i].currentTurn());
+            ASSERT_EQ(arena.gameState(slots[i]), games[i].gameState());
+            ASSERT_EQ(arena.encode(slots[i]), games[i].encode());
+            for (int row = -1; row <= BOARD_ROWS; ++row) {
+                for (int col = -1; col <= BOARD_COLS; ++col) {
+                    ASSERT_EQ(arena.pieceAt(slots[i], row, col), games[i].pieceAt(row, col));
+                }
+            }
+        }
+    }
+}
+
+
+TEST(GameArenaTest, reset_keeps_turn)
+{
+    // This test checks that reset clears the board but, like Piezas::reset, does not
+    // give the turn back to X.
+    GameArena arena;
+    const int slot = arena.create();
+    arena.dropPiece(slot, 0);
+    arena.reset(slot);
+
+    ASSERT_EQ(arena.pieceAt(slot, 0, 0), Blank);
+    ASSERT_EQ(arena.currentTurn(slot), O);
+    ASSERT_EQ(arena.gameState(slot), Invalid);
+}
+
+
+TEST(GameArenaTest, destroyed_slots_are_reused)
+{
+    // This test checks that a destroyed slot holds no game, and that create hands it
+    // out again as a fresh game before growing the pools.
+    GameArena arena;
+    const int first = arena.create();
+    const int second = arena.create();
+    arena.dropPiece(second, 2);
+    arena.destroy(second);
+
+    ASSERT_FALSE(arena.isLive(second));
+    ASSERT_EQ(arena.size(), 1u);
+    ASSERT_EQ(arena.dropPiece(second, 0), Invalid);
+    ASSERT_EQ(arena.pieceAt(second, 0, 2), Invalid);
+    ASSERT_EQ(arena.gameState(second), Invalid);
+
+    ASSERT_EQ(arena.create(), second);
+    ASSERT_EQ(arena.slotCount(), 2u);
+    ASSERT_EQ(arena.pieceAt(second, 0, 2), Blank);
+    ASSERT_EQ(arena.currentTurn(second), X);
+    ASSERT_TRUE(arena.isLive(first));
+}
+
+
+TEST(GameArenaTest, dropPieces_matches_dropPiece)
+{
+    // This test applies the same moves to two arenas, one game at a time and in bulk,
+    // until every game is over, then compares the outcomes.
+    GameArena single, bulk;
+    std::vector<int> slots;
+    for (int i = 0; i < 100; ++i) {
+        slots.push_back(single.create());
+        bulk.create();
+    }
+
+    std::vector<int> columns(slots.size());
+    std::vector<Piece> placed(slots.size());
+    unsigned int state = 3;
+    for (int move = 0; move < 30; ++move) {
+        const int column = move % BOARD_COLS;
+        bulk.dropPieces(&slots[0], slots.size(), column, &placed[0]);
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            ASSERT_EQ(placed[i], single.dropPiece(slots[i], column));
+        }
+
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            state = state * 1103515245 + 12345;
+            columns[i] = static_cast<int>((state >> 16) % BOARD_COLS);
+            single.dropPiece(slots[i], columns[i]);
+        }
+        bulk.dropPieces(&slots[0], &columns[0], slots.size(), nullptr);
+    }
+
+    std::vector<Piece> outcomes(slots.size());
+    bulk.gameStates(&slots[0], slots.size(), &outcomes[0]);
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+        ASSERT_NE(outcomes[i], Invalid);
+        ASSERT_EQ(outcomes[i], single.gameState(slots[i]));
+    }
+}
+
+
+TEST(GameArenaTest, bytesPerGame_smaller_than_Piezas)
+{
+    // This test checks that a game in a full arena takes less memory than a Piezas object.
+    GameArena arena(1000);
+    ASSERT_EQ(arena.bytesPerGame(), 0);
+    for (int i = 0; i < 1000; ++i) {
+        arena.create();
+    }
+
+    ASSERT_GE(arena.bytes(), 1000 * (2 * sizeof(GameArena::Mask) + 2));
+    ASSERT_LT(arena.bytesPerGame(), sizeof(Piezas));
+}
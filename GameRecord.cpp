@@ -0,0 +1,204 @@
+#include "GameRecord.h"
+#include <cstring>
+
+const int GameRecord::MAX_MOVES;
+const std::size_t GameRecordWriter::BUFFER_SIZE;
+const std::size_t GameRecordReader::BUFFER_SIZE;
+
+namespace
+{
+    const unsigned char MAGIC[3] = { 'P', 'Z', 'R' };
+    const unsigned char VERSION = 1;
+    const std::size_t HEADER_BYTES = 6;
+
+    // A varint of up to 2 bytes and up to MAX_MOVES moves of 2 bits each.
+    const std::size_t MAX_RECORD_BYTES = 2 + (GameRecord::MAX_MOVES + 3) / 4;
+
+    static_assert(BOARD_COLS <= 4, "a move has to fit in 2 bits");
+    static_assert(GameRecord::MAX_MOVES * 4 + 3 < 128 * 128, "the record header has to fit in 2 bytes");
+
+    const Piece OUTCOMES[4] = { Invalid, X, O, Blank };
+
+    int outcomeCode(Piece winner)
+    {
+        for (int code = 0; code < 4; ++code) {
+            if (OUTCOMES[code] == winner)
+                return code;
+        }
+        return -1;
+    }
+}
+
+/**
+ * Plays the moves of a record on an empty board and returns the position.
+**/
+Piezas replayGame(const GameRecord &record)
+{
+    Piezas game;
+    for (int i = 0; i < record.moveCount; ++i) {
+        game.dropPiece(record.moves[i]);
+    }
+    return game;
+}
+
+/**
+ * Constructor writes the file header to "out".
+**/
+GameRecordWriter::GameRecordWriter(std::ostream &out)
+    : out(out), used(0), written(0)
+{
+    std::memcpy(buffer, MAGIC, sizeof(MAGIC));
+    buffer[3] = VERSION;
+    buffer[4] = BOARD_ROWS;
+    buffer[5] = BOARD_COLS;
+    used = HEADER_BYTES;
+}
+
+/**
+ * Destructor writes out whatever is left in the buffer.
+**/
+GameRecordWriter::~GameRecordWriter()
+{
+    flush();
+}
+
+/**
+ * Adds a game. Returns false, writing nothing, if it has more than
+ * GameRecord::MAX_MOVES moves, a column out of bounds or a winner which
+ * is not a Piece.
+**/
+bool GameRecordWriter::write(const GameRecord &record)
+{
+    return write(record.moves, record.moveCount, record.winner);
+}
+
+bool GameRecordWriter::write(const unsigned char *moves, int moveCount, Piece winner)
+{
+    const int outcome = outcomeCode(winner);
+    if (moveCount < 0 || moveCount > GameRecord::MAX_MOVES || outcome < 0)
+        return false;
+    for (int i = 0; i < moveCount; ++i) {
+        if (moves[i] >= BOARD_COLS)
+            return false;
+    }
+
+    if (used + MAX_RECORD_BYTES > BUFFER_SIZE)
+        flush();
+
+    const unsigned int header = static_cast<unsigned int>(moveCount) * 4 + outcome;
+    if (header < 128) {
+        buffer[used++] = static_cast<unsigned char>(header);
+    } else {
+        buffer[used++] = static_cast<unsigned char>(0x80 | (header & 0x7F));
+        buffer[used++] = static_cast<unsigned char>(header >> 7);
+    }
+
+    for (int i = 0; i < moveCount; i += 4) {
+        unsigned char packed = 0;
+        for (int j = 0; j < 4 && i + j < moveCount; ++j) {
+            packed |= static_cast<unsigned char>(moves[i + j] << (2 * j));
+        }
+        buffer[used++] = packed;
+    }
+    return true;
+}
+
+/**
+ * Writes out the buffer, and returns whether the stream is still good.
+**/
+bool GameRecordWriter::flush()
+{
+    if (used > 0) {
+        out.write(reinterpret_cast<const char *>(buffer), static_cast<std::streamsize>(used));
+        written += used;
+        used = 0;
+    }
+    out.flush();
+    return out.good();
+}
+
+/**
+ * Constructor sets up reading from "in". The file header is read and
+ * checked with the first record.
+**/
+GameRecordReader::GameRecordReader(std::istream &in)
+    : in(in), begin(0), end(0), headerRead(false), error(false)
+{
+}
+
+/**
+ * Reads more of the stream unless "wanted" bytes are buffered already.
+ * Returns the number of bytes buffered.
+**/
+std::size_t GameRecordReader::fill(std::size_t wanted)
+{
+    if (end - begin >= wanted || !in)
+        return end - begin;
+
+    // Move what is left to the front, and read as much as fits after it.
+    std::memmove(buffer, buffer + begin, end - begin);
+    end -= begin;
+    begin = 0;
+    while (end < BUFFER_SIZE && in) {
+        in.read(reinterpret_cast<char *>(buffer + end), static_cast<std::streamsize>(BUFFER_SIZE - end));
+        end += static_cast<std::size_t>(in.gcount());
+    }
+    return end;
+}
+
+/**
+ * Reads the next game into "record". Returns false at the end of the
+ * stream, or if the data is not a valid record, see failed().
+**/
+bool GameRecordReader::read(GameRecord &record)
+{
+    if (error)
+        return false;
+
+    if (!headerRead) {
+        if (fill(HEADER_BYTES) < HEADER_BYTES || std::memcmp(buffer + begin, MAGIC, sizeof(MAGIC)) != 0
+            || buffer[begin + 3] != VERSION || buffer[begin + 4] != BOARD_ROWS || buffer[begin + 5] != BOARD_COLS) {
+            error = true;
+            return false;
+        }
+        begin += HEADER_BYTES;
+        headerRead = true;
+    }
+
+    const std::size_t available = fill(MAX_RECORD_BYTES);
+    if (available == 0)
+        return false;
+
+    // The record header, then the moves.
+    const unsigned char *data = buffer + begin;
+    unsigned int header = data[0];
+    std::size_t length = 1;
+    if (header & 0x80) {
+        if (available < 2 || (data[1] & 0x80)) {
+            error = true;
+            return false;
+        }
+        header = (header & 0x7F) | (static_cast<unsigned int>(data[1]) << 7);
+        length = 2;
+    }
+
+    const int move_count = static_cast<int>(header / 4);
+    const std::size_t move_bytes = static_cast<std::size_t>(move_count + 3) / 4;
+    if (move_count > GameRecord::MAX_MOVES || available < length + move_bytes) {
+        error = true;
+        return false;
+    }
+
+    for (int i = 0; i < move_count; ++i) {
+        record.moves[i] = static_cast<unsigned char>((data[length + i / 4] >> (2 * (i % 4))) & 3);
+    }
+    if (move_count % 4 != 0 && (data[length + move_bytes - 1] >> (2 * (move_count % 4))) != 0) {
+        error = true;
+        return false;
+    }
+
+    record.moveCount = move_count;
+    record.winner = OUTCOMES[header % 4];
+    begin += length + move_bytes;
+    return true;
+}
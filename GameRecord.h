@@ -0,0 +1,132 @@
+#ifndef _GAME_RECORD_H_
+#define _GAME_RECORD_H_
+#include "Piezas.h"
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+/**
+ * A whole 3x4 game: the columns dropped into from the empty board, X
+ * first, and how the game ended.
+**/
+struct GameRecord
+{
+  	static const int MAX_MOVES = 1023;
+
+  	// The winner, Blank for a tie, or Invalid if the game was not finished.
+  	Piece winner;
+  	int moveCount;
+  	// Columns from 0 to BOARD_COLS - 1. A column which is full loses the
+  	// turn, as in dropPiece.
+  	unsigned char moves[MAX_MOVES];
+};
+
+/**
+ * Plays the moves of a record on an empty board and returns the position.
+**/
+Piezas replayGame(const GameRecord &record);
+
+/**
+ * Writes game records to a stream in the binary record format:
+ *
+ *  file header: 'P' 'Z' 'R', format version 1, rows, columns (6 bytes)
+ *  each record: moveCount * 4 + outcome, as a 1 or 2 byte varint, where
+ *               the outcome is 0 for an unfinished game, 1 for X, 2 for O
+ *               and 3 for a tie; then the moves, 2 bits each, four to a
+ *               byte starting with the low bits, unused bits zero.
+ *
+ * A game of 20 moves takes 6 bytes. Records are gathered in a buffer inside
+ * the writer and written out when it fills up, so writing allocates no
+ * memory.
+**/
+class GameRecordWriter
+{
+  public:
+  	/**
+  	 * Constructor writes the file header to "out".
+  	**/
+  	explicit GameRecordWriter(std::ostream &out);
+
+  	/**
+  	 * Destructor writes out whatever is left in the buffer.
+  	**/
+  	~GameRecordWriter();
+
+  	/**
+  	 * Adds a game. Returns false, writing nothing, if it has more than
+  	 * GameRecord::MAX_MOVES moves, a column out of bounds or a winner which
+  	 * is not a Piece.
+  	**/
+  	bool write(const GameRecord &record);
+  	bool write(const unsigned char *moves, int moveCount, Piece winner);
+
+  	/**
+  	 * Writes out the buffer, and returns whether the stream is still good.
+  	**/
+  	bool flush();
+
+  	/**
+  	 * Returns the number of bytes written so far, buffered or not,
+  	 * including the file header.
+  	**/
+  	std::uint64_t bytesWritten() const { return written + used; }
+
+  	static const std::size_t BUFFER_SIZE = 1 << 14;
+
+  private:
+  	std::ostream &out;
+  	unsigned char buffer[BUFFER_SIZE];
+  	std::size_t used;
+  	std::uint64_t written;
+
+  	GameRecordWriter(const GameRecordWriter &);
+  	GameRecordWriter &operator=(const GameRecordWriter &);
+};
+
+/**
+ * Reads game records written by GameRecordWriter from a stream, through a
+ * buffer inside the reader, so reading allocates no memory either.
+**/
+class GameRecordReader
+{
+  public:
+  	/**
+  	 * Constructor sets up reading from "in". The file header is read and
+  	 * checked with the first record.
+  	**/
+  	explicit GameRecordReader(std::istream &in);
+
+  	/**
+  	 * Reads the next game into "record". Returns false at the end of the
+  	 * stream, or if the data is not a valid record, see failed().
+  	**/
+  	bool read(GameRecord &record);
+
+  	/**
+  	 * Returns whether reading stopped on data which is not valid, rather
+  	 * than at the end of the stream.
+  	**/
+  	bool failed() const { return error; }
+
+  	static const std::size_t BUFFER_SIZE = 1 << 14;
+
+  private:
+  	std::istream &in;
+  	unsigned char buffer[BUFFER_SIZE];
+  	std::size_t begin;
+  	std::size_t end;
+  	bool headerRead;
+  	bool error;
+
+  	/**
+  	 * Reads more of the stream unless "wanted" bytes are buffered already.
+  	 * Returns the number of bytes buffered.
+  	**/
+  	std::size_t fill(std::size_t wanted);
+
+  	GameRecordReader(const GameRecordReader &);
+  	GameRecordReader &operator=(const GameRecordReader &);
+};
+
+#endif /*_GAME_RECORD_H_*/
@@ -0,0 +1,159 @@
+/**
+ * Unit Tests for GameRecordWriter and GameRecordReader
+**/
+
+#include <gtest/gtest.h>
+#include "GameRecord.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Plays a pseudo-random game to the end, dropping into full columns now and then,
+    // and records its moves.
+    Piezas playRandomGame(unsigned int &state, GameRecord &record)
+    {
+        Piezas game;
+        record.moveCount = 0;
+        while (game.gameState() == Invalid) {
+            state = state * 1103515245 + 12345;
+            const int column = static_cast<int>((state >> 16) % BOARD_COLS);
+            game.dropPiece(column);
+            record.moves[record.moveCount++] = static_cast<unsigned char>(column);
+        }
+        record.winner = game.gameState();
+        return game;
+    }
+
+    // The text dump the archive keeps of a finished match: the 12 pieceAt results
+    // and the turn of the final position, on one line.
+    std::string textDump(const Piezas &game)
+    {
+        std::string text;
+        for (int row = 0; row < BOARD_ROWS; ++row) {
+            for (int col = 0; col < BOARD_COLS; ++col) {
+                text += static_cast<char>(game.pieceAt(row, col));
+            }
+        }
+        text += static_cast<char>(game.currentTurn());
+        text += '\n';
+        return text;
+    }
+}
+
+
+TEST(GameRecordTest, round_trip_matches_Piezas)
+{
+    // This test writes thousands of games, reads them back, and checks that replaying
+    // every record gives the same final position and winner as the game that was played.
+    std::vector<Piezas> finals;
+    std::stringstream stream;
+    GameRecord record;
+    unsigned int state = 23;
+    {
+        GameRecordWriter writer(stream);
+        for (int i = 0; i < 3000; ++i) {
+            finals.push_back(playRandomGame(state, record));
+            ASSERT_TRUE(writer.write(record));
+        }
+    }
+
+    GameRecordReader reader(stream);
+    for (std::size_t i = 0; i < finals.size(); ++i) {
+        ASSERT_TRUE(reader.read(record));
+        Piezas replayed = replayGame(record);
+        ASSERT_TRUE(replayed == finals[i]);
+        ASSERT_EQ(replayed.encode(), finals[i].encode());
+        ASSERT_EQ(replayed.gameState(), record.winner);
+    }
+    ASSERT_FALSE(reader.read(record));
+    ASSERT_FALSE(reader.failed());
+}
+
+
+TEST(GameRecordTest, smaller_than_text_dump)
+{
+    // This test compares the size of the binary records of typical games with the text
+    // dump of their final positions. A record keeps every move as well, so it is about
+    // half the size of the dump rather than a tenth; the position on its own, as
+    // encode() packs it, takes 4 bytes.
+    std::stringstream stream;
+    GameRecordWriter writer(stream);
+    GameRecord record;
+    unsigned int state = 8;
+    std::size_t text_bytes = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        const Piezas game = playRandomGame(state, record);
+        writer.write(record);
+        text_bytes += textDump(game).size();
+    }
+    writer.flush();
+
+    ASSERT_EQ(stream.str().size(), writer.bytesWritten());
+    ASSERT_EQ(text_bytes, 1000u * (BOARD_ROWS * BOARD_COLS + 2));
+    ASSERT_LE(writer.bytesWritten() * 2, text_bytes);
+    ASSERT_LT(sizeof(std::uint32_t) * 3, textDump(Piezas()).size());
+}
+
+
+TEST(GameRecordTest, long_and_unfinished_games)
+{
+    // This test round trips a game with the most moves a record holds, which needs a
+    // 2 byte record header, and an empty unfinished game, and checks that games which
+    // do not fit the format are refused.
+    std::stringstream stream;
+    GameRecord longest;
+    longest.moveCount = GameRecord::MAX_MOVES;
+    longest.winner = O;
+    for (int i = 0; i < longest.moveCount; ++i) {
+        longest.moves[i] = static_cast<unsigned char>(i % BOARD_COLS);
+    }
+    {
+        GameRecordWriter writer(stream);
+        ASSERT_TRUE(writer.write(longest));
+        ASSERT_TRUE(writer.write(longest.moves, 0, Invalid));
+        ASSERT_TRUE(writer.write(longest.moves, 5, Blank));
+
+        const unsigned char out_of_bounds[] = { 0, 4 };
+        ASSERT_FALSE(writer.write(out_of_bounds, 2, X));
+        ASSERT_FALSE(writer.write(longest.moves, GameRecord::MAX_MOVES + 1, X));
+        ASSERT_FALSE(writer.write(longest.moves, 1, static_cast<Piece>('Z')));
+    }
+
+    GameRecordReader reader(stream);
+    GameRecord record;
+    ASSERT_TRUE(reader.read(record));
+    ASSERT_EQ(record.moveCount, GameRecord::MAX_MOVES);
+    ASSERT_EQ(record.winner, O);
+    for (int i = 0; i < record.moveCount; ++i) {
+        ASSERT_EQ(record.moves[i], longest.moves[i]);
+    }
+    ASSERT_TRUE(reader.read(record));
+    ASSERT_EQ(record.moveCount, 0);
+    ASSERT_EQ(record.winner, Invalid);
+    ASSERT_TRUE(reader.read(record));
+    ASSERT_EQ(record.moveCount, 5);
+    ASSERT_EQ(record.winner, Blank);
+    ASSERT_FALSE(reader.read(record));
+    ASSERT_FALSE(reader.failed());
+}
+
+
+TEST(GameRecordTest, bad_data_fails)
+{
+    // This test checks that a wrong file header and a record cut short are reported as
+    // failures rather than as the end of the stream.
+    GameRecord record;
+
+    std::istringstream wrong_header(std::string("PZX\x01\x03\x04", 6));
+    GameRecordReader wrong(wrong_header);
+    ASSERT_FALSE(wrong.read(record));
+    ASSERT_TRUE(wrong.failed());
+
+    std::istringstream cut_short(std::string("PZR\x01\x03\x04\x31\x00", 8));
+    GameRecordReader cut(cut_short);
+    ASSERT_FALSE(cut.read(record));
+    ASSERT_TRUE(cut.failed());
+}
@@ -0,0 +1,781 @@
+#include "GameServer.h"
+#include "ConcurrentPiezas.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace GameProtocol;
+
+namespace
+{
+    void writeWord(std::uint32_t value, unsigned char *out)
+    {
+        out[0] = static_cast<unsigned char>(value);
+        out[1] = static_cast<unsigned char>(value >> 8);
+        out[2] = static_cast<unsigned char>(value >> 16);
+        out[3] = static_cast<unsigned char>(value >> 24);
+    }
+
+    std::uint32_t readWord(const unsigned char *in)
+    {
+        return std::uint32_t(in[0]) | (std::uint32_t(in[1]) << 8) | (std::uint32_t(in[2]) << 16)
+             | (std::uint32_t(in[3]) << 24);
+    }
+
+    /**
+     * Fills in a Unix-domain socket address. Returns false if the path is
+     * too long for one.
+    **/
+    bool unixAddress(const std::string &path, sockaddr_un &address)
+    {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+            return false;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    /**
+     * Fills in an IPv4 socket address from "host:port" or a host and a
+     * port. Returns false if the host is not an IPv4 address.
+    **/
+    bool tcpAddress(const std::string &host, int port, sockaddr_in &address)
+    {
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(port));
+        return inet_pton(AF_INET, host.c_str(), &address.sin_addr) == 1;
+    }
+
+    std::string systemError(const std::string &what)
+    {
+        return what + ": " + std::strerror(errno);
+    }
+
+    // A connection stops being read while this many response bytes wait to
+    // be sent, until the client reads them.
+    const std::size_t MAX_PENDING_OUTPUT = 1 << 20;
+    const std::size_t INPUT_BYTES = 1 << 16;
+}
+
+void GameProtocol::writeRequest(const Request &request, unsigned char *out)
+{
+    out[0] = request.op;
+    out[1] = static_cast<unsigned char>(request.column);
+    writeWord(request.game, out + 2);
+}
+
+Request GameProtocol::readRequest(const unsigned char *in)
+{
+    const Request request = { in[0], static_cast<signed char>(in[1]), readWord(in + 2) };
+    return request;
+}
+
+void GameProtocol::writeResponse(const Response &response, unsigned char *out)
+{
+    out[0] = response.status;
+    out[1] = response.piece;
+    writeWord(response.value, out + 2);
+}
+
+Response GameProtocol::readResponse(const unsigned char *in)
+{
+    const Response response = { in[0], in[1], readWord(in + 2) };
+    return response;
+}
+
+/**
+ * One loop of the server, with the games and connections only its thread
+ * touches.
+**/
+struct GameServer::Shard
+{
+    struct Connection
+    {
+        int fd;
+        bool closed;
+        bool dirty;
+        bool reading;
+        bool writing;
+        std::size_t inUsed;
+        std::size_t outSent;
+        std::vector<unsigned char> out;
+        unsigned char in[INPUT_BYTES];
+    };
+
+    int index;
+    int shardCount;
+    int listenFd;
+    int epollFd;
+    int wakeFd;
+    std::string address;
+    bool unixSocket;
+    std::thread thread;
+    GameArena arena;
+
+    // Indexed by file descriptor.
+    std::vector<std::unique_ptr<Connection> > connections;
+
+    std::atomic<std::uint64_t> accepted;
+    std::atomic<std::uint64_t> answered;
+
+    Shard(int index, int shardCount)
+        : index(index), shardCount(shardCount), listenFd(-1), epollFd(-1), wakeFd(-1),
+          unixSocket(false), accepted(0), answered(0)
+    {
+    }
+
+    ~Shard()
+    {
+        close();
+    }
+
+    /**
+     * Closes every socket of the shard, once its loop has stopped.
+    **/
+    void close()
+    {
+        for (std::size_t fd = 0; fd < connections.size(); ++fd) {
+            if (connections[fd])
+                ::close(static_cast<int>(fd));
+        }
+        connections.clear();
+        if (listenFd >= 0)
+            ::close(listenFd);
+        if (epollFd >= 0)
+            ::close(epollFd);
+        if (wakeFd >= 0)
+            ::close(wakeFd);
+        listenFd = epollFd = wakeFd = -1;
+        if (unixSocket)
+            unlink(address.c_str());
+        unixSocket = false;
+    }
+
+    /**
+     * Opens the listening socket and the epoll instance. Returns an error
+     * message, or an empty string.
+    **/
+    std::string open(const Config &config)
+    {
+        if (!config.unixPath.empty()) {
+            address = GameServer::address(config, index, 0);
+            sockaddr_un local;
+            if (!unixAddress(address, local))
+                return "socket path too long: " + address;
+            listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (listenFd < 0)
+                return systemError("socket");
+            unlink(address.c_str());
+            if (bind(listenFd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0)
+                return systemError("bind " + address);
+            unixSocket = true;
+        } else {
+            sockaddr_in local;
+            if (!tcpAddress(config.host, config.port ? config.port + index : 0, local))
+                return "not an IPv4 address: " + config.host;
+            listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (listenFd < 0)
+                return systemError("socket");
+            const int on = 1;
+            setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (bind(listenFd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0)
+                return systemError("bind " + config.host);
+            socklen_t length = sizeof(local);
+            getsockname(listenFd, reinterpret_cast<sockaddr *>(&local), &length);
+            address = GameServer::address(config, index, ntohs(local.sin_port));
+        }
+        if (listen(listenFd, SOMAXCONN) != 0)
+            return systemError("listen " + address);
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0)
+            return systemError("epoll");
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+        event.data.fd = wakeFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+        return std::string();
+    }
+
+    void wake()
+    {
+        const std::uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+
+    /**
+     * Watches a connection for input unless too much output is waiting,
+     * and for the socket to take more output if some is waiting.
+    **/
+    void watch(Connection &connection)
+    {
+        const bool pending = connection.outSent < connection.out.size();
+        const bool reading = connection.out.size() - connection.outSent < MAX_PENDING_OUTPUT;
+        if (reading == connection.reading && pending == connection.writing)
+            return;
+        connection.reading = reading;
+        connection.writing = pending;
+        epoll_event event;
+        event.events = (reading ? EPOLLIN : 0u) | (pending ? EPOLLOUT : 0u);
+        event.data.fd = connection.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+
+    void acceptAll()
+    {
+        for (;;) {
+            const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return;
+            if (!unixSocket) {
+                const int on = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            }
+            if (connections.size() <= static_cast<std::size_t>(fd))
+                connections.resize(fd + 1);
+            connections[fd].reset(new Connection());
+            Connection &connection = *connections[fd];
+            connection.fd = fd;
+            connection.closed = false;
+            connection.dirty = false;
+            connection.reading = true;
+            connection.writing = false;
+            connection.inUsed = 0;
+            connection.outSent = 0;
+
+            epoll_event event;
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+            accepted.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Response answer(const Request &request)
+    {
+        Response response = { OK, 0, 0 };
+        if (request.op == CREATE) {
+            const int slot = arena.create();
+            response.piece = static_cast<unsigned char>(arena.currentTurn(slot));
+            response.value = static_cast<std::uint32_t>(slot) * shardCount + index;
+            return response;
+        }
+
+        const int slot = static_cast<int>(request.game / shardCount);
+        if (request.op < DROP || request.op > CLOSE) {
+            response.status = BAD_REQUEST;
+        } else if (static_cast<int>(request.game % shardCount) != index || !arena.isLive(slot)) {
+            response.status = NO_GAME;
+        } else if (request.op == DROP) {
+            response.piece = static_cast<unsigned char>(arena.dropPiece(slot, request.column));
+            response.value = arena.encode(slot);
+        } else if (request.op == CLOSE) {
+            arena.destroy(slot);
+            response.value = request.game;
+        } else {
+            if (request.op == RESET)
+                arena.reset(slot);
+            response.piece = static_cast<unsigned char>(arena.gameState(slot));
+            response.value = arena.encode(slot);
+        }
+        return response;
+    }
+
+    /**
+     * Reads what has arrived on a connection and answers every complete
+     * request, adding the responses to its output.
+    **/
+    void readFrom(Connection &connection)
+    {
+        const ssize_t received = recv(connection.fd, connection.in + connection.inUsed,
+                                      INPUT_BYTES - connection.inUsed, 0);
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EINTR)) {
+            connection.closed = true;
+            return;
+        }
+        if (received < 0)
+            return;
+        connection.inUsed += static_cast<std::size_t>(received);
+
+        const std::size_t count = connection.inUsed / MESSAGE_BYTES;
+        const std::size_t old_size = connection.out.size();
+        connection.out.resize(old_size + count * MESSAGE_BYTES);
+        for (std::size_t i = 0; i < count; ++i) {
+            writeResponse(answer(readRequest(connection.in + i * MESSAGE_BYTES)),
+                          &connection.out[old_size + i * MESSAGE_BYTES]);
+        }
+        connection.inUsed -= count * MESSAGE_BYTES;
+        std::memmove(connection.in, connection.in + count * MESSAGE_BYTES, connection.inUsed);
+        answered.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /**
+     * Sends as much of a connection's output as the socket takes.
+    **/
+    void writeTo(Connection &connection)
+    {
+        while (connection.outSent < connection.out.size()) {
+            const ssize_t sent = ::send(connection.fd, &connection.out[connection.outSent],
+                                        connection.out.size() - connection.outSent, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno != EAGAIN && errno != EINTR)
+                    connection.closed = true;
+                break;
+            }
+            connection.outSent += static_cast<std::size_t>(sent);
+        }
+        if (connection.outSent == connection.out.size()) {
+            connection.out.clear();
+            connection.outSent = 0;
+        }
+    }
+
+    void closeConnection(int fd)
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections[fd].reset();
+    }
+
+    void run()
+    {
+        const int MAX_EVENTS = 256;
+        epoll_event events[MAX_EVENTS];
+        std::vector<Connection *> dirty;
+
+        for (;;) {
+            const int ready = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+            if (ready < 0) {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+
+            // Answer everything which has arrived, then write once per connection.
+            for (int e = 0; e < ready; ++e) {
+                const int fd = events[e].data.fd;
+                if (fd == wakeFd)
+                    return;
+                if (fd == listenFd) {
+                    acceptAll();
+                    continue;
+                }
+                Connection &connection = *connections[fd];
+                if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    readFrom(connection);
+                if (!connection.dirty) {
+                    connection.dirty = true;
+                    dirty.push_back(&connection);
+                }
+            }
+
+            for (Connection *connection : dirty) {
+                connection->dirty = false;
+                if (!connection->closed)
+                    writeTo(*connection);
+                if (connection->closed) {
+                    closeConnection(connection->fd);
+                } else {
+                    watch(*connection);
+                }
+            }
+            dirty.clear();
+        }
+    }
+};
+
+/**
+ * Constructor sets up a server with the given configuration. Nothing
+ * listens until start.
+**/
+GameServer::GameServer(const Config &config)
+    : config(config), running(false)
+{
+    if (this->config.shards < 1)
+        this->config.shards = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    if (this->config.host.empty())
+        this->config.host = "127.0.0.1";
+}
+
+/**
+ * Destructor stops the server.
+**/
+GameServer::~GameServer()
+{
+    stop();
+}
+
+/**
+ * Opens the listening sockets and starts the loops. Returns false,
+ * with the reason in error(), if a socket cannot be opened.
+**/
+bool GameServer::start()
+{
+    if (running)
+        return true;
+
+    shards.clear();
+    for (int i = 0; i < config.shards; ++i) {
+        shards.emplace_back(new Shard(i, config.shards));
+        lastError = shards.back()->open(config);
+        if (!lastError.empty()) {
+            shards.clear();
+            return false;
+        }
+    }
+    for (std::unique_ptr<Shard> &shard : shards) {
+        Shard *loop = shard.get();
+        shard->thread = std::thread([loop] { loop->run(); });
+    }
+    running = true;
+    return true;
+}
+
+/**
+ * Stops the loops and closes every socket.
+**/
+void GameServer::stop()
+{
+    if (!running)
+        return;
+    for (std::unique_ptr<Shard> &shard : shards) {
+        shard->wake();
+    }
+    for (std::unique_ptr<Shard> &shard : shards) {
+        shard->thread.join();
+        shard->close();
+    }
+    running = false;
+}
+
+/**
+ * Returns the address of a shard, for GameClient::connect: the path
+ * of its Unix-domain socket, or host:port.
+**/
+std::string GameServer::address(int shard) const
+{
+    return (shard >= 0 && shard < shardCount()) ? shards[shard]->address : std::string();
+}
+
+/**
+ * Returns the address shard "shard" of a server with the given
+ * configuration listens on, with the port for TCP taken from "port".
+**/
+std::string GameServer::address(const Config &config, int shard, int port)
+{
+    if (!config.unixPath.empty())
+        return config.unixPath + "." + std::to_string(shard);
+    return (config.host.empty() ? std::string("127.0.0.1") : config.host) + ":" + std::to_string(port);
+}
+
+/**
+ * Returns the connections accepted and requests answered so far.
+**/
+GameServer::Stats GameServer::stats() const
+{
+    Stats total = { 0, 0 };
+    for (const std::unique_ptr<Shard> &shard : shards) {
+        total.connections += shard->accepted.load(std::memory_order_relaxed);
+        total.requests += shard->answered.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+GameClient::GameClient()
+    : fd(-1), inBegin(0), inEnd(0)
+{
+}
+
+GameClient::~GameClient()
+{
+    close();
+}
+
+/**
+ * Connects to an address returned by GameServer::address. Returns
+ * whether the connection was made.
+**/
+bool GameClient::connect(const std::string &address)
+{
+    close();
+    const std::size_t colon = address.rfind(':');
+    if (address.find('/') != std::string::npos || colon == std::string::npos) {
+        sockaddr_un remote;
+        if (!unixAddress(address, remote))
+            return false;
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&remote), sizeof(remote)) != 0)
+            close();
+    } else {
+        sockaddr_in remote;
+        if (!tcpAddress(address.substr(0, colon), std::atoi(address.c_str() + colon + 1), remote))
+            return false;
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&remote), sizeof(remote)) != 0)
+            close();
+        if (fd >= 0) {
+            const int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+    }
+    return fd >= 0;
+}
+
+void GameClient::close()
+{
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+    out.clear();
+    inBegin = inEnd = 0;
+}
+
+/**
+ * Adds a request to the buffer.
+**/
+void GameClient::send(const Request &request)
+{
+    out.resize(out.size() + MESSAGE_BYTES);
+    writeRequest(request, &out[out.size() - MESSAGE_BYTES]);
+}
+
+/**
+ * Writes out the buffered requests. Returns false if the connection
+ * failed.
+**/
+bool GameClient::flush()
+{
+    std::size_t sent = 0;
+    while (sent < out.size()) {
+        const ssize_t written = ::send(fd, &out[sent], out.size() - sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        sent += static_cast<std::size_t>(written);
+    }
+    out.clear();
+    return true;
+}
+
+/**
+ * Reads the next response, waiting for it if "wait" is set. Returns
+ * false if there is none yet, or the connection failed.
+**/
+bool GameClient::receive(Response &response, bool wait)
+{
+    while (inEnd - inBegin < MESSAGE_BYTES) {
+        if (inBegin > 0) {
+            std::memmove(in, in + inBegin, inEnd - inBegin);
+            inEnd -= inBegin;
+            inBegin = 0;
+        }
+        const ssize_t received = recv(fd, in + inEnd, sizeof(in) - inEnd, wait ? 0 : MSG_DONTWAIT);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return false;
+        inEnd += static_cast<std::size_t>(received);
+    }
+    response = readResponse(in + inBegin);
+    inBegin += MESSAGE_BYTES;
+    return true;
+}
+
+/**
+ * Sends one request and waits for its response.
+**/
+bool GameClient::call(const Request &request, Response &response)
+{
+    send(request);
+    return flush() && receive(response);
+}
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct LoadResult
+    {
+        bool ok;
+        std::uint64_t moves;
+        std::uint64_t requests;
+        std::uint64_t gamesFinished;
+        // In nanoseconds, which a 32-bit count would wrap after 4.29 seconds.
+        std::vector<std::uint64_t> latencies;
+    };
+
+    /**
+     * Plays "games" games on one connection, keeping up to "window" requests
+     * in flight, with at most one per game.
+    **/
+    void playConnection(const std::string &address, int games, const LoadConfig &config,
+                        std::uint64_t seed, LoadResult &result)
+    {
+        result.ok = false;
+        GameClient client;
+        if (!client.connect(address))
+            return;
+
+        // Create the games.
+        std::vector<std::uint32_t> ids(games);
+        Response response;
+        for (int g = 0; g < games; ++g) {
+            const Request create = { CREATE, 0, 0 };
+            client.send(create);
+        }
+        if (!client.flush())
+            return;
+        for (int g = 0; g < games; ++g) {
+            if (!client.receive(response) || response.status != OK)
+                return;
+            ids[g] = response.value;
+        }
+
+        // Every game waits in "ready" until its next request goes out. A game
+        // which ended is reset before it plays on.
+        std::vector<int> moves_left(games, config.movesPerGame);
+        std::vector<bool> over(games, false);
+        std::deque<int> ready;
+        for (int g = 0; g < games; ++g) {
+            if (config.movesPerGame > 0)
+                ready.push_back(g);
+        }
+        std::deque<std::pair<int, Clock::time_point> > in_flight;
+        std::uint64_t state = seed | 1;
+        result.latencies.reserve(static_cast<std::size_t>(games) * config.movesPerGame * 2);
+
+        while (!ready.empty() || !in_flight.empty()) {
+            bool sent = false;
+            while (!ready.empty() && in_flight.size() < static_cast<std::size_t>(config.window)) {
+                const int g = ready.front();
+                ready.pop_front();
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                const Request request = { static_cast<unsigned char>(over[g] ? RESET : DROP),
+                                          static_cast<signed char>(state % BOARD_COLS), ids[g] };
+                client.send(request);
+                in_flight.push_back(std::make_pair(g, Clock::time_point()));
+                sent = true;
+            }
+            if (sent) {
+                const Clock::time_point now = Clock::now();
+                for (auto it = in_flight.rbegin(); it != in_flight.rend() && it->second == Clock::time_point(); ++it) {
+                    it->second = now;
+                }
+                if (!client.flush())
+                    return;
+            }
+
+            // Wait for one response, then take all which have arrived with it.
+            bool wait = true;
+            while (!in_flight.empty() && client.receive(response, wait)) {
+                wait = false;
+                const int g = in_flight.front().first;
+                result.latencies.push_back(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - in_flight.front().second).count()));
+                in_flight.pop_front();
+                ++result.requests;
+                if (response.status != OK)
+                    return;
+
+                if (over[g]) {
+                    over[g] = false;
+                } else {
+                    ++result.moves;
+                    --moves_left[g];
+                    if (ConcurrentPiezas::Snapshot(response.value).gameState() != Invalid) {
+                        over[g] = true;
+                        ++result.gamesFinished;
+                    }
+                }
+                if (moves_left[g] > 0)
+                    ready.push_back(g);
+            }
+            if (wait)
+                return;
+        }
+
+        for (int g = 0; g < games; ++g) {
+            const Request close = { CLOSE, 0, ids[g] };
+            client.send(close);
+        }
+        if (!client.flush())
+            return;
+        for (int g = 0; g < games; ++g) {
+            if (!client.receive(response) || response.status != OK)
+                return;
+        }
+        result.ok = true;
+    }
+}
+
+/**
+ * Creates the games, plays them from a thread per connection, closes them,
+ * and returns what it measured.
+**/
+LoadStats runLoad(const LoadConfig &config)
+{
+    LoadStats stats = { false, 0, 0, 0, 0, 0, 0, 0 };
+    const int shard_count = static_cast<int>(config.addresses.size());
+    const int per_shard = std::max(1, config.connectionsPerShard);
+    const int connection_count = shard_count * per_shard;
+    if (connection_count == 0 || config.games < 1 || config.window < 1)
+        return stats;
+
+    std::vector<LoadResult> results(connection_count);
+    std::vector<std::thread> threads;
+    const Clock::time_point start = Clock::now();
+    for (int c = 0; c < connection_count; ++c) {
+        // Spread the games as evenly as they go.
+        const int games = config.games / connection_count + (c < config.games % connection_count ? 1 : 0);
+        results[c].ok = false;
+        results[c].moves = results[c].requests = results[c].gamesFinished = 0;
+        threads.emplace_back(playConnection, config.addresses[c % shard_count], games, std::cref(config),
+                             config.seed + 0x9E3779B97F4A7C15ull * (c + 1), std::ref(results[c]));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<std::uint64_t> latencies;
+    stats.ok = true;
+    for (const LoadResult &result : results) {
+        stats.ok = stats.ok && result.ok;
+        stats.moves += result.moves;
+        stats.requests += result.requests;
+        stats.gamesFinished += result.gamesFinished;
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+    }
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        stats.p50Micros = latencies[latencies.size() / 2] / 1e3;
+        stats.p99Micros = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)] / 1e3;
+        stats.maxMicros = latencies.back() / 1e3;
+    }
+    return stats;
+}
@@ -0,0 +1,248 @@
+#ifndef _GAME_SERVER_H_
+#define _GAME_SERVER_H_
+#include "GameArena.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * The binary protocol of GameServer. Every message either way is 6 bytes,
+ * and responses come back in the order of the requests, so a client can
+ * send many requests before reading any response.
+ *
+ * A request is the operation (1 byte), the column for DROP (1 byte, signed)
+ * and the game id (4 bytes, little endian). A response is the Status
+ * (1 byte), a Piece (1 byte) and a value (4 bytes, little endian):
+ *   CREATE  starts a game. Piece: whose turn it is. Value: the game id.
+ *   DROP    plays Piezas::dropPiece. Piece: what it returned. Value: the
+ *           position afterwards, packed as by Piezas::encode.
+ *   QUERY   Piece: what Piezas::gameState returns. Value: the position.
+ *   RESET   plays Piezas::reset. Piece: gameState. Value: the position.
+ *   CLOSE   ends the game. Value: the game id.
+ * A request for a game the server does not have is answered with NO_GAME,
+ * and an unknown operation with BAD_REQUEST.
+**/
+namespace GameProtocol
+{
+  	enum Op
+  	{
+  	  	CREATE = 1,
+  	  	DROP = 2,
+  	  	QUERY = 3,
+  	  	RESET = 4,
+  	  	CLOSE = 5
+  	};
+
+  	enum Status
+  	{
+  	  	OK = 0,
+  	  	NO_GAME = 1,
+  	  	BAD_REQUEST = 2
+  	};
+
+  	const std::size_t MESSAGE_BYTES = 6;
+
+  	struct Request
+  	{
+  	  	unsigned char op;
+  	  	signed char column;
+  	  	std::uint32_t game;
+  	};
+
+  	struct Response
+  	{
+  	  	unsigned char status;
+  	  	unsigned char piece;
+  	  	std::uint32_t value;
+  	};
+
+  	void writeRequest(const Request &request, unsigned char *out);
+  	Request readRequest(const unsigned char *in);
+  	void writeResponse(const Response &response, unsigned char *out);
+  	Response readResponse(const unsigned char *in);
+}
+
+/**
+ * Serves Piezas games over TCP or Unix-domain sockets.
+ *
+ * The games are split into shards, each served by one thread running its
+ * own epoll loop over its own listening socket, connections and GameArena,
+ * so the shards share nothing and take no locks. A game lives in the shard
+ * of its id modulo the number of shards, and clients send the requests for
+ * a game to that shard's address. Every loop reads whatever requests have
+ * arrived on its ready connections, answers them, and then writes each
+ * connection's responses with a single send.
+**/
+class GameServer
+{
+  public:
+  	struct Config
+  	{
+  	  	// The number of shards, or one per core if not positive.
+  	  	int shards;
+  	  	// Listen on Unix-domain sockets at this path followed by "." and
+  	  	// the shard number if set, and on TCP otherwise.
+  	  	std::string unixPath;
+  	  	// The IPv4 address and first port to listen on over TCP. Shard i
+  	  	// listens on port + i, or on a port of the system's choosing if
+  	  	// port is 0.
+  	  	std::string host;
+  	  	int port;
+  	};
+
+  	struct Stats
+  	{
+  	  	std::uint64_t connections;
+  	  	std::uint64_t requests;
+  	};
+
+  	/**
+  	 * Constructor sets up a server with the given configuration. Nothing
+  	 * listens until start.
+  	**/
+  	explicit GameServer(const Config &config);
+
+  	/**
+  	 * Destructor stops the server.
+  	**/
+  	~GameServer();
+
+  	/**
+  	 * Opens the listening sockets and starts the loops. Returns false,
+  	 * with the reason in error(), if a socket cannot be opened.
+  	**/
+  	bool start();
+
+  	/**
+  	 * Stops the loops and closes every socket.
+  	**/
+  	void stop();
+
+  	int shardCount() const { return static_cast<int>(shards.size()); }
+
+  	/**
+  	 * Returns the address of a shard, for GameClient::connect: the path
+  	 * of its Unix-domain socket, or host:port.
+  	**/
+  	std::string address(int shard) const;
+
+  	/**
+  	 * Returns the connections accepted and requests answered so far.
+  	**/
+  	Stats stats() const;
+
+  	const std::string &error() const { return lastError; }
+
+  	/**
+  	 * Returns the address shard "shard" of a server with the given
+  	 * configuration listens on, with the port for TCP taken from "port".
+  	**/
+  	static std::string address(const Config &config, int shard, int port);
+
+  private:
+  	struct Shard;
+
+  	Config config;
+  	std::vector<std::unique_ptr<Shard> > shards;
+  	std::string lastError;
+  	bool running;
+};
+
+/**
+ * A blocking connection to one shard of a GameServer. Requests are buffered
+ * by send until flush, so many can go out in one write, and responses are
+ * read back one at a time in the same order.
+**/
+class GameClient
+{
+  public:
+  	GameClient();
+  	~GameClient();
+
+  	/**
+  	 * Connects to an address returned by GameServer::address. Returns
+  	 * whether the connection was made.
+  	**/
+  	bool connect(const std::string &address);
+
+  	void close();
+
+  	/**
+  	 * Adds a request to the buffer.
+  	**/
+  	void send(const GameProtocol::Request &request);
+
+  	/**
+  	 * Writes out the buffered requests. Returns false if the connection
+  	 * failed.
+  	**/
+  	bool flush();
+
+  	/**
+  	 * Reads the next response, waiting for it if "wait" is set. Returns
+  	 * false if there is none yet, or the connection failed.
+  	**/
+  	bool receive(GameProtocol::Response &response, bool wait = true);
+
+  	/**
+  	 * Sends one request and waits for its response.
+  	**/
+  	bool call(const GameProtocol::Request &request, GameProtocol::Response &response);
+
+  private:
+  	int fd;
+  	std::vector<unsigned char> out;
+  	unsigned char in[1 << 16];
+  	std::size_t inBegin;
+  	std::size_t inEnd;
+
+  	GameClient(const GameClient &);
+  	GameClient &operator=(const GameClient &);
+};
+
+/**
+ * Plays games against a GameServer from many connections at once, and
+ * measures how long the server takes to answer.
+**/
+struct LoadConfig
+{
+  	// The address of every shard, in shard order.
+  	std::vector<std::string> addresses;
+  	// The games played at the same time, spread evenly over the shards.
+  	int games;
+  	// The connections to each shard.
+  	int connectionsPerShard;
+  	// The moves to play in every game; a game which ends is reset and
+  	// played on.
+  	int movesPerGame;
+  	// The requests a connection keeps in flight.
+  	int window;
+  	std::uint64_t seed;
+};
+
+struct LoadStats
+{
+  	// Whether every connection was made and every response was OK.
+  	bool ok;
+  	std::uint64_t moves;
+  	std::uint64_t requests;
+  	std::uint64_t gamesFinished;
+  	double seconds;
+  	// Latency of the requests, from when they were written until their
+  	// response was read, in microseconds.
+  	double p50Micros;
+  	double p99Micros;
+  	double maxMicros;
+
+  	double movesPerSecond() const { return seconds > 0 ? moves / seconds : 0; }
+};
+
+/**
+ * Creates the games, plays them from a thread per connection, closes them,
+ * and returns what it measured.
+**/
+LoadStats runLoad(const LoadConfig &config);
+
+#endif /*_GAME_SERVER_H_*/
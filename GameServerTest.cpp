@@ -0,0 +1,169 @@
+/**
+ * Unit Tests for GameServer
+**/
+
+#include <gtest/gtest.h>
+#include "GameServer.h"
+#include "Piezas.h"
+#include <string>
+#include <unistd.h>
+
+using namespace GameProtocol;
+
+namespace
+{
+    GameServer::Config tcpConfig(int shards)
+    {
+        GameServer::Config config = { shards, "", "127.0.0.1", 0 };
+        return config;
+    }
+
+    Request request(Op op, std::uint32_t game, int column = 0)
+    {
+        const Request made = { static_cast<unsigned char>(op), static_cast<signed char>(column), game };
+        return made;
+    }
+}
+
+
+TEST(GameServerTest, messages_round_trip)
+{
+    // This test writes a request and a response to bytes and reads them back.
+    unsigned char bytes[MESSAGE_BYTES];
+    writeRequest(request(DROP, 0x12345678, -1), bytes);
+    ASSERT_EQ(bytes[0], DROP);
+    ASSERT_EQ(bytes[2], 0x78);
+    ASSERT_EQ(bytes[5], 0x12);
+    const Request read_request = readRequest(bytes);
+    ASSERT_EQ(read_request.op, DROP);
+    ASSERT_EQ(read_request.column, -1);
+    ASSERT_EQ(read_request.game, 0x12345678u);
+
+    const Response response = { NO_GAME, static_cast<unsigned char>(X), 0xFEDCBA98u };
+    writeResponse(response, bytes);
+    const Response read_response = readResponse(bytes);
+    ASSERT_EQ(read_response.status, NO_GAME);
+    ASSERT_EQ(read_response.piece, X);
+    ASSERT_EQ(read_response.value, 0xFEDCBA98u);
+}
+
+
+TEST(GameServerTest, plays_like_Piezas_over_tcp)
+{
+    // This test plays a game on every shard of a two-shard server and compares each
+    // answer with a local Piezas, then sends requests the server has to refuse.
+    GameServer server(tcpConfig(2));
+    ASSERT_TRUE(server.start()) << server.error();
+    ASSERT_EQ(server.shardCount(), 2);
+
+    for (int shard = 0; shard < 2; ++shard) {
+        GameClient client;
+        ASSERT_TRUE(client.connect(server.address(shard)));
+        Response response;
+        ASSERT_TRUE(client.call(request(CREATE, 0), response));
+        ASSERT_EQ(response.status, OK);
+        ASSERT_EQ(response.piece, X);
+        const std::uint32_t game = response.value;
+        ASSERT_EQ(game % 2, static_cast<std::uint32_t>(shard));
+
+        Piezas local;
+        const int columns[] = { 0, 1, 4, 2, 3, 0, 0, 0, 1, 2, 3, 1, 2, 3, -1, 1, 2, 3 };
+        for (int column : columns) {
+            ASSERT_TRUE(client.call(request(DROP, game, column), response));
+            ASSERT_EQ(response.status, OK);
+            ASSERT_EQ(response.piece, local.dropPiece(column));
+            ASSERT_EQ(response.value, local.encode());
+        }
+        ASSERT_TRUE(client.call(request(QUERY, game), response));
+        ASSERT_EQ(response.piece, local.gameState());
+        ASSERT_EQ(response.value, local.encode());
+
+        local.reset();
+        ASSERT_TRUE(client.call(request(RESET, game), response));
+        ASSERT_EQ(response.piece, Invalid);
+        ASSERT_EQ(response.value, local.encode());
+
+        // The other shard's ids, unknown operations and closed games are refused.
+        ASSERT_TRUE(client.call(request(QUERY, game + 1), response));
+        ASSERT_EQ(response.status, NO_GAME);
+        ASSERT_TRUE(client.call(request(static_cast<Op>(9), game), response));
+        ASSERT_EQ(response.status, BAD_REQUEST);
+        ASSERT_TRUE(client.call(request(CLOSE, game), response));
+        ASSERT_EQ(response.status, OK);
+        ASSERT_TRUE(client.call(request(QUERY, game), response));
+        ASSERT_EQ(response.status, NO_GAME);
+    }
+
+    server.stop();
+    ASSERT_EQ(server.stats().connections, 2u);
+}
+
+
+TEST(GameServerTest, pipelines_over_unix_sockets)
+{
+    // This test sends a thousand requests in one write over a Unix-domain socket and
+    // reads every answer back in order.
+    const std::string path = "/tmp/GameServerTest." + std::to_string(getpid());
+    GameServer::Config config = { 1, path, "", 0 };
+    GameServer server(config);
+    ASSERT_TRUE(server.start()) << server.error();
+    ASSERT_EQ(server.address(0), path + ".0");
+
+    GameClient client;
+    ASSERT_TRUE(client.connect(server.address(0)));
+    Response response;
+    ASSERT_TRUE(client.call(request(CREATE, 0), response));
+    const std::uint32_t game = response.value;
+
+    Piezas local;
+    std::vector<Piece> expected;
+    std::vector<std::uint32_t> codes;
+    for (int i = 0; i < 1000; ++i) {
+        if (local.gameState() != Invalid) {
+            client.send(request(RESET, game));
+            local.reset();
+            expected.push_back(Invalid);
+        } else {
+            const int column = (i * 7) % BOARD_COLS;
+            client.send(request(DROP, game, column));
+            expected.push_back(local.dropPiece(column));
+        }
+        codes.push_back(local.encode());
+    }
+    ASSERT_TRUE(client.flush());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_TRUE(client.receive(response));
+        ASSERT_EQ(response.status, OK);
+        ASSERT_EQ(response.piece, expected[i]);
+        ASSERT_EQ(response.value, codes[i]);
+    }
+    ASSERT_FALSE(client.receive(response, false));
+
+    server.stop();
+    ASSERT_EQ(server.stats().requests, 1001u);
+    ASSERT_NE(access((path + ".0").c_str(), F_OK), 0);
+}
+
+
+TEST(GameServerTest, load_plays_ten_thousand_games)
+{
+    // This test runs the load generator with ten thousand games over two shards and
+    // checks that every move was played and answered.
+    GameServer server(tcpConfig(2));
+    ASSERT_TRUE(server.start()) << server.error();
+
+    LoadConfig load = { std::vector<std::string>(), 10000, 2, 3, 128, 7 };
+    for (int shard = 0; shard < server.shardCount(); ++shard) {
+        load.addresses.push_back(server.address(shard));
+    }
+    const LoadStats stats = runLoad(load);
+
+    ASSERT_TRUE(stats.ok);
+    ASSERT_EQ(stats.moves, 30000u);
+    ASSERT_EQ(stats.requests, stats.moves);
+    ASSERT_GT(stats.movesPerSecond(), 0);
+    ASSERT_LE(stats.p50Micros, stats.p99Micros);
+    ASSERT_LE(stats.p99Micros, stats.maxMicros);
+    // The creates and closes go through the server as well.
+    ASSERT_EQ(server.stats().requests, 30000u + 2 * 10000u);
+}
@@ -0,0 +1,247 @@
+#include "LogReplay.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const std::size_t LogReplayer::CHUNK_BYTES;
+
+namespace
+{
+    /**
+     * Returns the outcome a log line records with the given character, or
+     * false if it is not one.
+    **/
+    bool recordedOutcome(char c, Piece &outcome)
+    {
+        switch (c) {
+        case 'X': outcome = X; return true;
+        case 'O': outcome = O; return true;
+        case 'T': outcome = Blank; return true;
+        case '?': outcome = Invalid; return true;
+        default: return false;
+        }
+    }
+
+    char outcomeCharacter(Piece outcome)
+    {
+        switch (outcome) {
+        case X: return 'X';
+        case O: return 'O';
+        case Blank: return 'T';
+        default: return '?';
+        }
+    }
+
+    /**
+     * Replays one line, without its newline. Returns false if it is
+     * malformed, and otherwise sets the recorded and replayed outcomes.
+    **/
+    bool replayLine(const char *line, std::size_t length, Piece &recorded, Piece &replayed)
+    {
+        if (length > 0 && line[length - 1] == '\r')
+            --length;
+        if (length < 2 || line[length - 2] != ' ' || !recordedOutcome(line[length - 1], recorded))
+            return false;
+
+        Piezas game;
+        for (std::size_t i = 0; i + 2 < length; ++i) {
+            const unsigned int column = static_cast<unsigned char>(line[i]) - '0';
+            if (column > 9)
+                return false;
+            game.dropPiece(static_cast<int>(column));
+        }
+        replayed = game.gameState();
+        return true;
+    }
+
+    long pageSize()
+    {
+        static const long size = sysconf(_SC_PAGESIZE);
+        return size;
+    }
+
+    /**
+     * Gives back the pages which lie completely inside [begin, end).
+    **/
+    void releasePages(const char *begin, const char *end)
+    {
+        const std::uintptr_t page = static_cast<std::uintptr_t>(pageSize());
+        const std::uintptr_t first = (reinterpret_cast<std::uintptr_t>(begin) + page - 1) & ~(page - 1);
+        const std::uintptr_t last = reinterpret_cast<std::uintptr_t>(end) & ~(page - 1);
+        if (first < last)
+            madvise(reinterpret_cast<void *>(first), last - first, MADV_DONTNEED);
+    }
+}
+
+/**
+ * Writes the log line of a record to "line", which needs room for
+ * GameRecord::MAX_MOVES + 3 characters, and returns its length. The line
+ * ends with a newline and is not null terminated.
+**/
+std::size_t formatLogLine(const GameRecord &record, char *line)
+{
+    std::size_t length = 0;
+    for (int i = 0; i < record.moveCount; ++i) {
+        line[length++] = static_cast<char>('0' + record.moves[i]);
+    }
+    line[length++] = ' ';
+    line[length++] = outcomeCharacter(record.winner);
+    line[length++] = '\n';
+    return length;
+}
+
+/**
+ * Constructor sets up replays on the given number of threads, or one per
+ * core if "threads" is not positive, and the access mode.
+**/
+LogReplayer::LogReplayer(int threads, Access access)
+    : access(access)
+{
+    if (threads < 1)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    this->threads = (threads < 1) ? 1 : threads;
+}
+
+/**
+ * Replays the lines of the log file which start at byte "begin" up to,
+ * not including, byte "end" (the end of the file if "end" is past it).
+ * Only the pages holding those lines are read. Every mismatch is passed
+ * to "sink", unless it is empty.
+**/
+LogReplayer::Stats LogReplayer::replayFile(const char *path, const MismatchSink &sink,
+                                           std::uint64_t begin, std::uint64_t end) const
+{
+    Stats stats = { false, 0, 0, 0, 0, threads };
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return stats;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return stats;
+    }
+
+    const std::uint64_t size = static_cast<std::uint64_t>(info.st_size);
+    if (end > size)
+        end = size;
+    if (begin >= end) {
+        close(fd);
+        stats.ok = true;
+        return stats;
+    }
+
+    // Map from the page holding the byte before "begin", which tells whether
+    // a line starts at "begin", to the end of the file, where the last line
+    // may end. Mapping costs nothing until a page is touched.
+    const std::uint64_t page = static_cast<std::uint64_t>(pageSize());
+    const std::uint64_t map_start = ((begin > 0) ? begin - 1 : 0) & ~(page - 1);
+    const std::size_t map_size = static_cast<std::size_t>(size - map_start);
+    void *mapping = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(map_start));
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return stats;
+
+    const char *data = static_cast<const char *>(mapping);
+    const std::size_t from = static_cast<std::size_t>(begin - map_start);
+    const std::size_t to = static_cast<std::size_t>(end - map_start);
+    madvise(mapping, map_size, MADV_SEQUENTIAL);
+    if (access == PRELOAD) {
+        const std::size_t preload_start = static_cast<std::size_t>((from & ~(page - 1)));
+        madvise(const_cast<char *>(data) + preload_start, to - preload_start, MADV_WILLNEED);
+    }
+
+    stats = replay(data, map_size, from, to, map_start, access == ON_DEMAND, sink);
+    munmap(mapping, map_size);
+    return stats;
+}
+
+/**
+ * Replays a log already in memory. Offsets are from "data".
+**/
+LogReplayer::Stats LogReplayer::replayBuffer(const char *data, std::size_t size, const MismatchSink &sink) const
+{
+    return replay(data, size, 0, size, 0, false, sink);
+}
+
+/**
+ * Replays the lines starting in [from, to) of the mapped bytes [data,
+ * data + size), where data is at "base" bytes into the file, giving
+ * back the pages of each chunk when done if "releaseChunks" is set.
+**/
+LogReplayer::Stats LogReplayer::replay(const char *data, std::size_t size, std::size_t from, std::size_t to,
+                                       std::uint64_t base, bool releaseChunks, const MismatchSink &sink) const
+{
+    const auto start = std::chrono::steady_clock::now();
+    const Stats zero = { true, 0, 0, 0, 0, threads };
+
+    const std::size_t chunk_count = (to - from + CHUNK_BYTES - 1) / CHUNK_BYTES;
+    std::atomic<std::size_t> next_chunk(0);
+    std::mutex sink_mutex;
+
+    // Every worker counts into a Stats of its own and stores it once at the end.
+    std::vector<Stats> results(threads, zero);
+    auto work = [&](int self) {
+        Stats stats = zero;
+        for (std::size_t chunk = next_chunk++; chunk < chunk_count; chunk = next_chunk++) {
+            const std::size_t chunk_start = from + chunk * CHUNK_BYTES;
+            const std::size_t chunk_end = (chunk_start + CHUNK_BYTES < to) ? chunk_start + CHUNK_BYTES : to;
+
+            // The line running into the chunk belongs to the chunk before.
+            std::size_t position = chunk_start;
+            if (position > 0 && data[position - 1] != '\n') {
+                const void *newline = std::memchr(data + position, '\n', size - position);
+                position = newline ? static_cast<const char *>(newline) - data + 1 : size;
+            }
+
+            while (position < chunk_end) {
+                const void *newline = std::memchr(data + position, '\n', size - position);
+                const std::size_t line_end = newline ? static_cast<const char *>(newline) - data : size;
+
+                if (line_end > position) {
+                    ReplayMismatch mismatch = { base + position, false, Invalid, Invalid };
+                    mismatch.malformed = !replayLine(data + position, line_end - position,
+                                                     mismatch.recorded, mismatch.replayed);
+                    ++stats.games;
+                    if (mismatch.malformed || mismatch.recorded != mismatch.replayed) {
+                        ++stats.mismatches;
+                        if (sink) {
+                            std::lock_guard<std::mutex> lock(sink_mutex);
+                            sink(mismatch);
+                        }
+                    }
+                }
+                position = line_end + 1;
+            }
+
+            if (releaseChunks)
+                releasePages(data + chunk_start, data + chunk_end);
+        }
+        results[self] = stats;
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; ++t) {
+        workers.emplace_back(work, t);
+    }
+    work(0);
+    for (std::size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+
+    Stats total = zero;
+    for (int t = 0; t < threads; ++t) {
+        total.games += results[t].games;
+        total.mismatches += results[t].mismatches;
+    }
+    total.bytes = to - from;
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
@@ -0,0 +1,123 @@
+#ifndef _LOG_REPLAY_H_
+#define _LOG_REPLAY_H_
+#include "Piezas.h"
+#include "GameRecord.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * The move log is a text file with one game per line: the columns dropped
+ * into from the empty board, X first, as digits, then a space and the
+ * recorded outcome: X or O for the winner, T for a tie, or ? for a game
+ * which was not finished. For example "1201320312011 O". Every digit is a
+ * move, so columns out of bounds can be logged too, and lose the turn.
+**/
+
+/**
+ * Writes the log line of a record to "line", which needs room for
+ * GameRecord::MAX_MOVES + 3 characters, and returns its length. The line
+ * ends with a newline and is not null terminated.
+**/
+std::size_t formatLogLine(const GameRecord &record, char *line);
+
+/**
+ * A game whose replay does not match its log line.
+**/
+struct ReplayMismatch
+{
+  	// Where the line starts, in bytes from the start of the file.
+  	std::uint64_t offset;
+  	// Whether the line is not in the format of the log at all. If it is,
+  	// the outcome it records and the gameState of the replayed game.
+  	bool malformed;
+  	Piece recorded;
+  	Piece replayed;
+};
+
+/**
+ * Replays move logs through Piezas::dropPiece and checks every recorded
+ * outcome against Piezas::gameState.
+ *
+ * The log is memory-mapped rather than read, and cut into chunks of a
+ * fixed size which the threads take one after another. A line belongs to
+ * the chunk it starts in, so chunks can be cut anywhere and each thread
+ * finds the lines of its chunk by itself. Lines are parsed and replayed
+ * straight from the mapping, without copying them or allocating memory.
+ * Mismatches are handed to a callback as they are found, one at a time.
+**/
+class LogReplayer
+{
+  public:
+  	/**
+  	 * How the mapping is read.
+  	**/
+  	enum Access
+  	{
+  	  	// Read the whole mapped range in ahead of the threads, which is
+  	  	// the fastest way through a whole log.
+  	  	PRELOAD,
+  	  	// Only fault in pages as the threads reach them, and give each
+  	  	// chunk's pages back once it is done, so that only the pages being
+  	  	// replayed take up memory.
+  	  	ON_DEMAND
+  	};
+
+  	/**
+  	 * What a replay found.
+  	**/
+  	struct Stats
+  	{
+  	  	// Whether the log could be opened and mapped.
+  	  	bool ok;
+  	  	std::uint64_t games;
+  	  	std::uint64_t mismatches;
+  	  	std::uint64_t bytes;
+  	  	double seconds;
+  	  	int threads;
+
+  	  	double megabytesPerSecond() const { return seconds > 0 ? bytes / seconds / 1e6 : 0; }
+  	  	double gamesPerSecond() const { return seconds > 0 ? games / seconds : 0; }
+  	};
+
+  	typedef std::function<void(const ReplayMismatch &)> MismatchSink;
+
+  	/**
+  	 * Constructor sets up replays on the given number of threads, or one per
+  	 * core if "threads" is not positive, and the access mode.
+  	**/
+  	explicit LogReplayer(int threads = 0, Access access = PRELOAD);
+
+  	/**
+  	 * Replays the lines of the log file which start at byte "begin" up to,
+  	 * not including, byte "end" (the end of the file if "end" is past it).
+  	 * Only the pages holding those lines are read. Every mismatch is passed
+  	 * to "sink", unless it is empty.
+  	**/
+  	Stats replayFile(const char *path, const MismatchSink &sink,
+  	                 std::uint64_t begin = 0, std::uint64_t end = ~std::uint64_t(0)) const;
+
+  	/**
+  	 * Replays a log already in memory. Offsets are from "data".
+  	**/
+  	Stats replayBuffer(const char *data, std::size_t size, const MismatchSink &sink) const;
+
+  	/**
+  	 * The size of the chunks the log is cut into.
+  	**/
+  	static const std::size_t CHUNK_BYTES = 1 << 20;
+
+  private:
+  	int threads;
+  	Access access;
+
+  	/**
+  	 * Replays the lines starting in [from, to) of the mapped bytes [data,
+  	 * data + size), where data is at "base" bytes into the file, giving
+  	 * back the pages of each chunk when done if "releaseChunks" is set.
+  	**/
+  	Stats replay(const char *data, std::size_t size, std::size_t from, std::size_t to,
+  	             std::uint64_t base, bool releaseChunks, const MismatchSink &sink) const;
+};
+
+#endif /*_LOG_REPLAY_H_*/
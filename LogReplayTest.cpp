@@ -0,0 +1,153 @@
+/**
+ * Unit Tests for LogReplayer
+**/
+
+#include <gtest/gtest.h>
+#include "LogReplay.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Builds a log of pseudo-random games, several chunks long. Every 1000th game has
+    // the wrong outcome, and every 1500th line is malformed. The offsets of those lines
+    // are added to "bad".
+    std::string makeLog(int games, std::vector<std::uint64_t> &bad)
+    {
+        std::string log;
+        GameRecord record;
+        char line[GameRecord::MAX_MOVES + 3];
+        unsigned int state = 77;
+
+        for (int i = 0; i < games; ++i) {
+            Piezas game;
+            record.moveCount = 0;
+            while (game.gameState() == Invalid) {
+                state = state * 1103515245 + 12345;
+                const int column = static_cast<int>((state >> 16) % BOARD_COLS);
+                game.dropPiece(column);
+                record.moves[record.moveCount++] = static_cast<unsigned char>(column);
+            }
+            record.winner = game.gameState();
+
+            if (i % 1500 == 1499) {
+                bad.push_back(log.size());
+                log += "12a3 X\n";
+            }
+            if (i % 1000 == 999) {
+                record.winner = (record.winner == X) ? O : X;
+                bad.push_back(log.size());
+            }
+            log.append(line, formatLogLine(record, line));
+        }
+        return log;
+    }
+
+    std::string writeTemporaryFile(const std::string &contents)
+    {
+        char path[] = "/tmp/LogReplayTestXXXXXX";
+        const int fd = mkstemp(path);
+        std::FILE *file = fdopen(fd, "wb");
+        std::fwrite(contents.data(), 1, contents.size(), file);
+        std::fclose(file);
+        return path;
+    }
+}
+
+
+TEST(LogReplayTest, formatLogLine)
+{
+    // This test checks the log line of a record.
+    GameRecord record;
+    record.moveCount = 3;
+    record.moves[0] = 1;
+    record.moves[1] = 3;
+    record.moves[2] = 0;
+    record.winner = Blank;
+    char line[GameRecord::MAX_MOVES + 3];
+
+    ASSERT_EQ(std::string(line, formatLogLine(record, line)), "130 T\n");
+}
+
+
+TEST(LogReplayTest, buffer_mismatches_on_any_thread_count)
+{
+    // This test replays a log of several chunks on 1 and 3 threads, and checks that
+    // every game is counted and every bad line is reported once.
+    std::vector<std::uint64_t> bad;
+    const std::string log = makeLog(150000, bad);
+    ASSERT_GT(log.size(), 2 * LogReplayer::CHUNK_BYTES);
+
+    for (int threads = 1; threads <= 3; threads += 2) {
+        std::vector<std::uint64_t> reported;
+        const LogReplayer::Stats stats = LogReplayer(threads).replayBuffer(log.data(), log.size(),
+            [&](const ReplayMismatch &mismatch) { reported.push_back(mismatch.offset); });
+
+        std::sort(reported.begin(), reported.end());
+        ASSERT_TRUE(stats.ok);
+        ASSERT_EQ(stats.games, 150000u + 100u);
+        ASSERT_EQ(stats.mismatches, bad.size());
+        ASSERT_EQ(stats.bytes, log.size());
+        ASSERT_EQ(reported, bad);
+    }
+}
+
+
+TEST(LogReplayTest, lines)
+{
+    // This test checks single lines: a Windows line ending, a game with out of bounds
+    // and full columns, an unfinished game, a missing outcome and a last line without
+    // a newline.
+    const std::string log = "001122330123 O\r\n"
+                            "9000111 ?\n"
+                            "\n"
+                            "0123\n"
+                            "000111222333 T";
+    std::vector<ReplayMismatch> reported;
+    const LogReplayer::Stats stats = LogReplayer(1).replayBuffer(log.data(), log.size(),
+        [&](const ReplayMismatch &mismatch) { reported.push_back(mismatch); });
+
+    ASSERT_EQ(stats.games, 4u);
+    ASSERT_EQ(reported.size(), 2u);
+    ASSERT_EQ(reported[0].offset, 0u);
+    ASSERT_FALSE(reported[0].malformed);
+    ASSERT_EQ(reported[0].recorded, O);
+    ASSERT_EQ(reported[0].replayed, Blank);
+    ASSERT_EQ(reported[1].offset, 27u);
+    ASSERT_TRUE(reported[1].malformed);
+}
+
+
+TEST(LogReplayTest, file_in_both_modes_and_ranges)
+{
+    // This test replays a log file whole in both access modes, and in two ranges cut in
+    // the middle of a line, which together replay every game once.
+    std::vector<std::uint64_t> bad;
+    const std::string log = makeLog(60000, bad);
+    const std::string path = writeTemporaryFile(log);
+
+    const LogReplayer::Access modes[] = { LogReplayer::PRELOAD, LogReplayer::ON_DEMAND };
+    for (LogReplayer::Access mode : modes) {
+        const LogReplayer replayer(2, mode);
+        const LogReplayer::Stats whole = replayer.replayFile(path.c_str(), LogReplayer::MismatchSink());
+        ASSERT_TRUE(whole.ok);
+        ASSERT_EQ(whole.games, 60000u + 40u);
+        ASSERT_EQ(whole.mismatches, bad.size());
+
+        const std::uint64_t middle = log.size() / 2 + 5;
+        std::vector<std::uint64_t> reported;
+        LogReplayer::MismatchSink sink = [&](const ReplayMismatch &mismatch) { reported.push_back(mismatch.offset); };
+        const LogReplayer::Stats first = replayer.replayFile(path.c_str(), sink, 0, middle);
+        const LogReplayer::Stats second = replayer.replayFile(path.c_str(), sink, middle);
+        ASSERT_EQ(first.games + second.games, whole.games);
+        ASSERT_EQ(first.bytes + second.bytes, log.size());
+        std::sort(reported.begin(), reported.end());
+        ASSERT_EQ(reported, bad);
+    }
+
+    std::remove(path.c_str());
+    ASSERT_FALSE(LogReplayer().replayFile(path.c_str(), LogReplayer::MismatchSink()).ok);
+}
@@ -0,0 +1,416 @@
+#include "Mcts.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef Piezas::Geometry Geometry;
+    typedef std::chrono::steady_clock Clock;
+
+    // Points of a finished game for one player, so that a node's score is
+    // twice its wins plus its ties.
+    const int WIN_POINTS = 2;
+    const int TIE_POINTS = 1;
+
+    // How many visits, each worth no points, a node on the path of an
+    // unfinished iteration counts in a shared tree.
+    const int VIRTUAL_LOSS = 1;
+
+    // The exploration constant of UCT, for results between 0 and 1.
+    const double EXPLORATION = 1.41421356;
+
+    // Iterations between two looks at the clock.
+    const int CLOCK_INTERVAL = 64;
+
+    // Placements and passes in the longest game the tree can hold: a pass
+    // never follows a pass.
+    const int MAX_DEPTH = 2 * Geometry::CELLS + 2;
+
+    // The states a node goes through, once each.
+    enum Expansion
+    {
+        UNEXPANDED = 0,
+        EXPANDING,
+        EXPANDED
+    };
+
+    /**
+     * The random stream of one search thread.
+    **/
+    struct Random
+    {
+        std::uint64_t state;
+
+        explicit Random(std::uint64_t seed)
+        {
+            state = PiezasZobrist<BOARD_ROWS, BOARD_COLS>::splitmix64(seed);
+            if (state == 0)
+                state = 0x9E3779B97F4A7C15ull;
+        }
+
+        // Returns a number from 0 to n - 1.
+        int below(int n)
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return static_cast<int>((((state * 0x2545F4914F6CDD1Dull) >> 32) * std::uint64_t(n)) >> 32);
+        }
+    };
+}
+
+/**
+ * A position in the tree, reached by dropping into "column". "visits" and
+ * "score" are from the point of view of the player who made that move, and
+ * are updated by every thread searching the tree. The children are
+ * "childCount" nodes in a row in the pool, starting at "firstChild".
+**/
+struct MctsPlayer::Node
+{
+    std::atomic<std::int32_t> visits;
+    std::atomic<std::int32_t> score;
+    std::atomic<std::uint32_t> firstChild;
+    std::atomic<unsigned char> expansion;
+    unsigned char childCount;
+    signed char column;
+    bool pass;
+};
+
+/**
+ * A fixed number of nodes, handed out in blocks by bumping an index. reset
+ * hands them all out again; nothing is ever freed one node at a time.
+**/
+class MctsPlayer::NodePool
+{
+  public:
+    static const std::uint32_t NONE = 0xFFFFFFFFu;
+
+    NodePool() : capacity(0), used(0) {}
+
+    void allocate(std::size_t count)
+    {
+        nodes.reset(new Node[count]);
+        capacity = count;
+    }
+
+    void reset()
+    {
+        used.store(0);
+    }
+
+    // Returns the first of "count" new nodes, or NONE if the pool is used up.
+    std::uint32_t take(std::size_t count)
+    {
+        const std::size_t first = used.fetch_add(count, std::memory_order_relaxed);
+        if (first + count > capacity)
+            return NONE;
+        return static_cast<std::uint32_t>(first);
+    }
+
+    Node &operator[](std::uint32_t index) { return nodes[index]; }
+
+    std::size_t size() const
+    {
+        const std::size_t taken = used.load();
+        return taken < capacity ? taken : capacity;
+    }
+
+  private:
+    std::unique_ptr<Node[]> nodes;
+    std::size_t capacity;
+    std::atomic<std::size_t> used;
+};
+
+/**
+ * One thread's share of a search: the tree it works on, the limits shared
+ * with the other threads, and its own random stream.
+**/
+struct MctsPlayer::Search
+{
+    NodePool &pool;
+    std::uint32_t root;
+    const Piezas &start;
+    const Budget &budget;
+    Clock::time_point deadline;
+    std::atomic<std::int64_t> &started;
+    std::atomic<bool> &stopped;
+    bool shared;
+    Random random;
+    std::int64_t playouts;
+
+    Search(NodePool &pool, std::uint32_t root, const Piezas &start, const Budget &budget,
+           Clock::time_point deadline, std::atomic<std::int64_t> &started, std::atomic<bool> &stopped,
+           bool shared, std::uint64_t seed)
+        : pool(pool), root(root), start(start), budget(budget), deadline(deadline), started(started),
+          stopped(stopped), shared(shared), random(seed), playouts(0)
+    {
+    }
+
+    /**
+     * Runs iterations until the budget is spent.
+    **/
+    void run()
+    {
+        for (;;) {
+            if (stopped.load(std::memory_order_relaxed))
+                return;
+            if (budget.iterations > 0 && started.fetch_add(1, std::memory_order_relaxed) >= budget.iterations) {
+                stopped.store(true);
+                return;
+            }
+            if (budget.seconds > 0 && playouts % CLOCK_INTERVAL == 0 && Clock::now() >= deadline) {
+                stopped.store(true);
+                return;
+            }
+            iterate();
+            ++playouts;
+        }
+    }
+
+    /**
+     * Adds the children of a node, unless another thread is already doing
+     * it or the pool is used up. Returns whether the node has children now.
+    **/
+    bool expand(Node &node, const Piezas &game, bool passed)
+    {
+        unsigned char expected = UNEXPANDED;
+        if (!node.expansion.compare_exchange_strong(expected, EXPANDING))
+            return expected == EXPANDED;
+
+        signed char columns[BOARD_COLS + 1];
+        int count = 0;
+        int full_column = -1;
+        const Piezas::Mask open = game.legalMoves();
+        for (int col = 0; col < BOARD_COLS; ++col) {
+            if ((open >> col) & 1) {
+                columns[count++] = static_cast<signed char>(col);
+            } else if (full_column < 0) {
+                full_column = col;
+            }
+        }
+        const int drops = count;
+        if (full_column >= 0 && !passed)
+            columns[count++] = static_cast<signed char>(full_column);
+
+        const std::uint32_t first = pool.take(count);
+        if (first == NodePool::NONE) {
+            node.expansion.store(UNEXPANDED);
+            return false;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            Node &child = pool[first + i];
+            child.visits.store(0, std::memory_order_relaxed);
+            child.score.store(0, std::memory_order_relaxed);
+            child.firstChild.store(NodePool::NONE, std::memory_order_relaxed);
+            child.expansion.store(UNEXPANDED, std::memory_order_relaxed);
+            child.childCount = 0;
+            child.column = columns[i];
+            child.pass = (i >= drops);
+        }
+        node.childCount = static_cast<unsigned char>(count);
+        node.firstChild.store(first, std::memory_order_relaxed);
+        node.expansion.store(EXPANDED, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Returns the child with the best UCT value, or the first child nobody
+     * has visited yet.
+    **/
+    std::uint32_t select(Node &node)
+    {
+        const std::uint32_t first = node.firstChild.load(std::memory_order_relaxed);
+        const double log_visits = std::log(double(node.visits.load(std::memory_order_relaxed)) + 1);
+        std::uint32_t best = first;
+        double best_value = -1;
+
+        for (std::uint32_t i = first; i < first + node.childCount; ++i) {
+            const std::int32_t visits = pool[i].visits.load(std::memory_order_relaxed);
+            if (visits == 0)
+                return i;
+            const double mean = pool[i].score.load(std::memory_order_relaxed) / (double(WIN_POINTS) * visits);
+            const double value = mean + EXPLORATION * std::sqrt(log_visits / visits);
+            if (value > best_value) {
+                best_value = value;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * Plays one iteration: selection, expansion, a random playout, and
+     * adding the result to every node on the path.
+    **/
+    void iterate()
+    {
+        Piezas game = start;
+        std::uint32_t path[MAX_DEPTH + 1];
+        Piece movers[MAX_DEPTH + 1];
+        int depth = 0;
+        bool passed = false;
+        const int loss = shared ? VIRTUAL_LOSS : 0;
+
+        path[0] = root;
+        movers[0] = Invalid;
+        pool[root].visits.fetch_add(loss, std::memory_order_relaxed);
+
+        // Walk down the tree, adding the children of the first node without
+        // any, and step into one of them.
+        bool descend = true;
+        while (descend && game.gameState() == Invalid && depth < MAX_DEPTH) {
+            Node &node = pool[path[depth]];
+            if (node.expansion.load(std::memory_order_acquire) != EXPANDED) {
+                descend = false;
+                if (!expand(node, game, passed))
+                    break;
+            }
+
+            const std::uint32_t child = select(node);
+            pool[child].visits.fetch_add(loss, std::memory_order_relaxed);
+            movers[depth + 1] = game.currentTurn();
+            game.dropPiece(pool[child].column);
+            passed = pool[child].pass;
+            path[++depth] = child;
+        }
+
+        // Play the game out, only into columns which are not full.
+        Piece winner = game.gameState();
+        while (winner == Invalid) {
+            int open_columns[BOARD_COLS];
+            const int open_count = game.orderedLegalMoves(open_columns);
+            game.dropPiece(open_columns[random.below(open_count)]);
+            winner = game.gameState();
+        }
+
+        for (int i = 0; i <= depth; ++i) {
+            Node &node = pool[path[i]];
+            int points = TIE_POINTS;
+            if (winner != Blank)
+                points = (winner == movers[i]) ? WIN_POINTS : 0;
+            node.visits.fetch_add(1 - loss, std::memory_order_relaxed);
+            node.score.fetch_add(points, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * Constructor allocates room for "maxNodes" tree nodes, to search with
+ * the given mode on "threads" threads (one per core if not positive;
+ * SERIAL always uses one). "seed" starts the random playouts, so serial
+ * searches with an iteration budget always pick the same moves.
+**/
+MctsPlayer::MctsPlayer(std::size_t maxNodes, Mode mode, int threads, std::uint64_t seed)
+    : mode(mode), seed(seed)
+{
+    if (threads < 1)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads < 1 || mode == SERIAL)
+        threads = 1;
+    this->threads = threads;
+
+    // Every tree needs at least its root and the root's children.
+    poolCount = (mode == ROOT_PARALLEL) ? threads : 1;
+    std::size_t pool_nodes = maxNodes / poolCount;
+    if (pool_nodes < BOARD_COLS + 2)
+        pool_nodes = BOARD_COLS + 2;
+
+    pools.reset(new NodePool[poolCount]);
+    for (int i = 0; i < poolCount; ++i) {
+        pools[i].allocate(pool_nodes);
+    }
+}
+
+MctsPlayer::~MctsPlayer()
+{
+}
+
+/**
+ * Searches the given position within the budget and returns the column
+ * the player to move should drop into.
+**/
+MctsPlayer::Result MctsPlayer::bestMove(const Piezas &game, const Budget &budget)
+{
+    const Clock::time_point begin = Clock::now();
+    Result result = { -1, 0, 0, 0 };
+
+    if (game.gameState() != Invalid || (budget.iterations <= 0 && budget.seconds <= 0))
+        return result;
+
+    const Clock::time_point deadline = begin + std::chrono::duration_cast<Clock::duration>(
+                                           std::chrono::duration<double>(budget.seconds));
+    std::atomic<std::int64_t> started(0);
+    std::atomic<bool> stopped(false);
+
+    // Start every tree over with a fresh root.
+    for (int i = 0; i < poolCount; ++i) {
+        pools[i].reset();
+        Node &root = pools[i][pools[i].take(1)];
+        root.visits.store(0);
+        root.score.store(0);
+        root.firstChild.store(NodePool::NONE);
+        root.expansion.store(UNEXPANDED);
+        root.childCount = 0;
+        root.column = -1;
+        root.pass = false;
+    }
+
+    // A serial search runs on this thread without setting anything up, so
+    // that it allocates no memory at all.
+    std::vector<Search> searches;
+    if (threads == 1) {
+        Search search(pools[0], 0, game, budget, deadline, started, stopped, false, seed);
+        search.run();
+        result.playouts = search.playouts;
+    } else {
+        searches.reserve(threads);
+        for (int t = 0; t < threads; ++t) {
+            NodePool &pool = pools[(mode == ROOT_PARALLEL) ? t : 0];
+            searches.emplace_back(pool, 0, game, budget, deadline, started, stopped,
+                                  mode == TREE_PARALLEL, seed + std::uint64_t(t));
+        }
+
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; ++t) {
+            workers.emplace_back(&Search::run, &searches[t]);
+        }
+        searches[0].run();
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+        for (int t = 0; t < threads; ++t) {
+            result.playouts += searches[t].playouts;
+        }
+    }
+
+    // Add up the visits of each root move over all trees, and play the one
+    // visited most.
+    std::int64_t visits[BOARD_COLS] = {};
+    for (int i = 0; i < poolCount; ++i) {
+        Node &root = pools[i][0];
+        result.nodes += pools[i].size();
+        if (root.expansion.load() != EXPANDED)
+            continue;
+        const std::uint32_t first = root.firstChild.load();
+        for (std::uint32_t c = first; c < first + root.childCount; ++c) {
+            visits[pools[i][c].column] += pools[i][c].visits.load();
+        }
+    }
+    for (int col = 0; col < BOARD_COLS; ++col) {
+        if (result.bestColumn < 0 || visits[col] > visits[result.bestColumn])
+            result.bestColumn = col;
+    }
+
+    // Without any visits, any column which is not full will do.
+    for (int col = 0; col < BOARD_COLS && visits[result.bestColumn] == 0; ++col) {
+        if ((game.legalMoves() >> col) & 1)
+            result.bestColumn = col;
+    }
+
+    result.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    return result;
+}
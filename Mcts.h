@@ -0,0 +1,112 @@
+#ifndef _MCTS_H_
+#define _MCTS_H_
+#include "Piezas.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Picks moves with Monte Carlo Tree Search. Every iteration walks down the
+ * search tree choosing children by UCT, adds the children of the position
+ * it reaches, plays the game out to the end with random dropPiece calls
+ * and adds the result to every node on the way. The move played most often
+ * from the root is the best move.
+ *
+ * The moves of a position are the columns which are not full, and one pass
+ * (a drop into a full column, which loses the turn) if some column is full
+ * and the previous move was not a pass already. Playouts only drop into
+ * columns which are not full.
+ *
+ * Nodes come from pools allocated once by the constructor. Every call to
+ * bestMove starts the pools over, so no memory is allocated or freed per
+ * node. When a pool runs out, the tree stops growing and the remaining
+ * iterations play out from the leaves.
+ *
+ * Search can run on several threads: either each thread grows a tree of its
+ * own and their root statistics are added up at the end (ROOT_PARALLEL),
+ * or all threads share one tree (TREE_PARALLEL). In a shared tree every
+ * node on the path of an iteration counts a virtual loss until the playout
+ * is over, which steers the other threads to different paths.
+**/
+class MctsPlayer
+{
+  public:
+  	enum Mode
+  	{
+  	  	SERIAL,
+  	  	ROOT_PARALLEL,
+  	  	TREE_PARALLEL
+  	};
+
+  	/**
+  	 * How long to search: at most "iterations" playouts and at most
+  	 * "seconds" of wall-clock time. A limit of 0 means no limit of that
+  	 * kind, but at least one of them has to be set.
+  	**/
+  	struct Budget
+  	{
+  	  	std::int64_t iterations;
+  	  	double seconds;
+
+  	  	static Budget ofIterations(std::int64_t iterations) { Budget budget = { iterations, 0 }; return budget; }
+  	  	static Budget ofSeconds(double seconds) { Budget budget = { 0, seconds }; return budget; }
+  	};
+
+  	/**
+  	 * What a search found.
+  	**/
+  	struct Result
+  	{
+  	  	// The column to drop into, or -1 if the game is already over.
+  	  	int bestColumn;
+  	  	// The number of playouts, the number of tree nodes used, and how
+  	  	// long the search took.
+  	  	std::int64_t playouts;
+  	  	std::size_t nodes;
+  	  	double seconds;
+
+  	  	double playoutsPerSecond() const { return seconds > 0 ? playouts / seconds : 0; }
+  	};
+
+  	/**
+  	 * Constructor allocates room for "maxNodes" tree nodes, to search with
+  	 * the given mode on "threads" threads (one per core if not positive;
+  	 * SERIAL always uses one). "seed" starts the random playouts, so serial
+  	 * searches with an iteration budget always pick the same moves.
+  	**/
+  	explicit MctsPlayer(std::size_t maxNodes = 1 << 20, Mode mode = SERIAL, int threads = 0, std::uint64_t seed = 1);
+
+  	~MctsPlayer();
+
+  	/**
+  	 * Searches the given position within the budget and returns the column
+  	 * the player to move should drop into.
+  	**/
+  	Result bestMove(const Piezas &game, const Budget &budget);
+
+  	/**
+  	 * Returns the mode and the number of threads searches run on.
+  	**/
+  	Mode searchMode() const { return mode; }
+  	int threadCount() const { return threads; }
+
+  private:
+  	// Defined in Mcts.cpp: a tree node, a fixed pool of nodes, and the
+  	// state of one thread's search.
+  	struct Node;
+  	class NodePool;
+  	struct Search;
+
+  	Mode mode;
+  	int threads;
+  	std::uint64_t seed;
+
+  	// One pool per tree: one per thread for ROOT_PARALLEL, one otherwise.
+  	std::unique_ptr<NodePool[]> pools;
+  	int poolCount;
+
+  	MctsPlayer(const MctsPlayer &);
+  	MctsPlayer &operator=(const MctsPlayer &);
+};
+
+#endif /*_MCTS_H_*/
@@ -0,0 +1,103 @@
+/**
+ * Unit Tests for MctsPlayer
+**/
+
+#include <gtest/gtest.h>
+#include "Mcts.h"
+#include "Solver.h"
+#include "TestHelpers.h"
+
+
+TEST(MctsTest, keeps_won_positions_won)
+{
+    // This test takes positions a few moves from the end which the player to move
+    // wins with perfect play, and checks that the move MCTS picks still wins.
+    Solver solver;
+    MctsPlayer player(1 << 16);
+    unsigned int state = 11;
+    int checked = 0;
+
+    while (checked < 20) {
+        const Piezas game = randomPosition(state, 4);
+        if (solver.solve(game).outcome != game.currentTurn())
+            continue;
+
+        const MctsPlayer::Result result = player.bestMove(game, MctsPlayer::Budget::ofIterations(5000));
+        Piezas next = game;
+        ASSERT_NE(next.dropPiece(result.bestColumn), Invalid);
+        ASSERT_EQ(solver.solve(next).outcome, game.currentTurn());
+        ++checked;
+    }
+}
+
+
+TEST(MctsTest, game_over_has_no_move)
+{
+    // This test checks that a finished game gets no move and no playouts.
+    MctsPlayer player(1024);
+    Piezas game;
+    for (int i = 0; i < BOARD_ROWS * BOARD_COLS; ++i) {
+        game.dropPiece(i % BOARD_COLS);
+    }
+
+    const MctsPlayer::Result result = player.bestMove(game, MctsPlayer::Budget::ofIterations(100));
+    ASSERT_EQ(result.bestColumn, -1);
+    ASSERT_EQ(result.playouts, 0);
+}
+
+
+TEST(MctsTest, iteration_budget_in_every_mode)
+{
+    // This test checks that every mode plays exactly the budgeted number of playouts
+    // and picks a column of the board.
+    const MctsPlayer::Mode modes[] = { MctsPlayer::SERIAL, MctsPlayer::ROOT_PARALLEL, MctsPlayer::TREE_PARALLEL };
+    for (MctsPlayer::Mode mode : modes) {
+        MctsPlayer player(1 << 14, mode, 3);
+        const MctsPlayer::Result result = player.bestMove(Piezas(), MctsPlayer::Budget::ofIterations(3000));
+        ASSERT_EQ(result.playouts, 3000);
+        ASSERT_GE(result.bestColumn, 0);
+        ASSERT_LT(result.bestColumn, BOARD_COLS);
+        ASSERT_GT(result.nodes, 1u);
+    }
+}
+
+
+TEST(MctsTest, time_budget)
+{
+    // This test checks that a search with only a time budget stops soon after it.
+    MctsPlayer player(1 << 16, MctsPlayer::TREE_PARALLEL, 2);
+    const MctsPlayer::Result result = player.bestMove(Piezas(), MctsPlayer::Budget::ofSeconds(0.05));
+
+    ASSERT_GE(result.seconds, 0.05);
+    ASSERT_LT(result.seconds, 1.0);
+    ASSERT_GT(result.playouts, 0);
+}
+
+
+TEST(MctsTest, small_pool_still_searches)
+{
+    // This test checks that a pool with room for only the root and its children
+    // still plays every budgeted playout.
+    MctsPlayer player(1);
+    const MctsPlayer::Result result = player.bestMove(Piezas(), MctsPlayer::Budget::ofIterations(500));
+
+    ASSERT_EQ(result.playouts, 500);
+    ASSERT_LE(result.nodes, static_cast<std::size_t>(BOARD_COLS + 2));
+}
+
+
+TEST(MctsTest, no_allocation_after_construction)
+{
+    // This test checks that serial searches take all their nodes from the pool
+    // allocated by the constructor, without allocating any memory of their own.
+    MctsPlayer player(1 << 16);
+    Piezas game;
+    game.dropPiece(1);
+
+    const long before = allocationCount();
+    const MctsPlayer::Result first = player.bestMove(game, MctsPlayer::Budget::ofIterations(20000));
+    const MctsPlayer::Result second = player.bestMove(game, MctsPlayer::Budget::ofSeconds(0.01));
+    ASSERT_EQ(allocationCount(), before);
+    ASSERT_GT(first.nodes, 1000u);
+    ASSERT_GT(second.playouts, 0);
+}
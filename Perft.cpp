@@ -0,0 +1,267 @@
+#include "Perft.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    const std::uint32_t EMPTY_SLOT = ~std::uint32_t(0);
+
+    /**
+     * Counts a node which is over, if it is. Returns whether it is.
+    **/
+    bool countOutcome(const Piezas &game, Perft::Ply &ply)
+    {
+        const Piece state = game.gameState();
+        if (state == Invalid)
+            return false;
+        if (state == X) {
+            ++ply.xWins;
+        } else if (state == O) {
+            ++ply.oWins;
+        } else {
+            ++ply.ties;
+        }
+        return true;
+    }
+
+    /**
+     * Counts the subtree of "game", which is at ply "ply", down to ply
+     * "depth". The moves are made on "game" and taken back.
+    **/
+    void countTree(Piezas &game, int ply, int depth, Perft::Ply *plies)
+    {
+        ++plies[ply].nodes;
+        if (countOutcome(game, plies[ply]) || ply == depth)
+            return;
+        for (int col = 0; col < BOARD_COLS; ++col) {
+            const Piezas::Move move = game.makeMove(col);
+            if (move.piece == Blank)
+                ++plies[ply + 1].lostTurns;
+            countTree(game, ply + 1, depth, plies);
+            game.unmakeMove(move);
+        }
+    }
+
+    void addPlies(std::vector<Perft::Ply> &total, const std::vector<Perft::Ply> &part)
+    {
+        for (std::size_t i = 0; i < total.size(); ++i) {
+            total[i].nodes += part[i].nodes;
+            total[i].xWins += part[i].xWins;
+            total[i].oWins += part[i].oWins;
+            total[i].ties += part[i].ties;
+            total[i].lostTurns += part[i].lostTurns;
+        }
+    }
+
+    /**
+     * An open-addressing set of position codes, grown at half full.
+    **/
+    class CodeSet
+    {
+      public:
+        CodeSet() : slots(1024, EMPTY_SLOT), used(0) {}
+
+        static std::uint32_t hash(std::uint32_t code)
+        {
+            return static_cast<std::uint32_t>((code * 0x9E3779B97F4A7C15ull) >> 32);
+        }
+
+        // Returns which of "threads" threads owns a code. It takes the high
+        // bits of the hash, which the table leaves to the low ones.
+        static int owner(std::uint32_t code, int threads)
+        {
+            return static_cast<int>((std::uint64_t(hash(code)) * threads) >> 32);
+        }
+
+        // Returns whether the code was new.
+        bool insert(std::uint32_t code)
+        {
+            if (2 * (used + 1) > slots.size())
+                grow();
+            if (!place(slots, code))
+                return false;
+            ++used;
+            return true;
+        }
+
+        void clear()
+        {
+            slots.assign(slots.size(), EMPTY_SLOT);
+            used = 0;
+        }
+
+      private:
+        std::vector<std::uint32_t> slots;
+        std::size_t used;
+
+        static bool place(std::vector<std::uint32_t> &table, std::uint32_t code)
+        {
+            const std::size_t mask = table.size() - 1;
+            for (std::size_t i = hash(code) & mask;; i = (i + 1) & mask) {
+                if (table[i] == code)
+                    return false;
+                if (table[i] == EMPTY_SLOT) {
+                    table[i] = code;
+                    return true;
+                }
+            }
+        }
+
+        void grow()
+        {
+            std::vector<std::uint32_t> bigger(2 * slots.size(), EMPTY_SLOT);
+            for (std::uint32_t code : slots) {
+                if (code != EMPTY_SLOT)
+                    place(bigger, code);
+            }
+            slots.swap(bigger);
+        }
+    };
+
+    /**
+     * Runs "work" for every thread number, the calling thread being the
+     * first, and waits for all of them.
+    **/
+    template <typename Work>
+    void onThreads(int threads, Work work)
+    {
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; ++t) {
+            workers.emplace_back(work, t);
+        }
+        work(0);
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+}
+
+/**
+ * Constructor sets up counting on the given number of threads, or on
+ * one thread per core if "threads" is not positive.
+**/
+Perft::Perft(int threads, Mode mode)
+    : mode(mode)
+{
+    if (threads < 1)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    this->threads = (threads < 1) ? 1 : threads;
+}
+
+/**
+ * Counts the plies from "root" down to "depth" moves deep.
+**/
+Perft::Result Perft::run(const Piezas &root, int depth) const
+{
+    const auto start = std::chrono::steady_clock::now();
+    if (depth < 0)
+        depth = 0;
+    const Ply zero = { 0, 0, 0, 0, 0 };
+    Result result;
+    result.plies.assign(depth + 1, zero);
+    result.threads = threads;
+
+    if (mode == TREE) {
+        runTree(root, depth, result.plies);
+    } else {
+        runMerged(root, depth, result.plies);
+    }
+
+    result.nodes = 0;
+    for (const Ply &ply : result.plies) {
+        result.nodes += ply.nodes;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void Perft::runTree(const Piezas &root, int depth, std::vector<Ply> &plies) const
+{
+    // Expand the top of the tree here, ply by ply, until there are enough
+    // subtrees to share out. Everything above the split ply is counted as
+    // it is expanded; the nodes at the split ply are counted by the threads.
+    std::vector<Piezas> frontier(1, root);
+    int split = 0;
+    while (split < depth && frontier.size() < 64 * static_cast<std::size_t>(threads)) {
+        std::vector<Piezas> next;
+        next.reserve(frontier.size() * BOARD_COLS);
+        for (const Piezas &game : frontier) {
+            ++plies[split].nodes;
+            if (countOutcome(game, plies[split]))
+                continue;
+            for (int col = 0; col < BOARD_COLS; ++col) {
+                Piezas child = game;
+                if (child.dropPiece(col) == Blank)
+                    ++plies[split + 1].lostTurns;
+                next.push_back(child);
+            }
+        }
+        frontier.swap(next);
+        ++split;
+    }
+
+    std::atomic<std::size_t> next_subtree(0);
+    std::vector<std::vector<Ply> > counts(threads, std::vector<Ply>(plies.size(), Ply()));
+    onThreads(threads, [&](int self) {
+        std::vector<Ply> &mine = counts[self];
+        for (std::size_t i = next_subtree++; i < frontier.size(); i = next_subtree++) {
+            Piezas game = frontier[i];
+            countTree(game, split, depth, &mine[0]);
+        }
+    });
+    for (const std::vector<Ply> &part : counts) {
+        addPlies(plies, part);
+    }
+}
+
+void Perft::runMerged(const Piezas &root, int depth, std::vector<Ply> &plies) const
+{
+    // Every code is owned by one thread, see CodeSet::owner.
+    // outbox[from][to] holds the new codes thread "from" found for "to".
+    std::vector<std::vector<std::uint32_t> > frontier(threads);
+    std::vector<std::vector<std::vector<std::uint32_t> > > outbox(threads,
+        std::vector<std::vector<std::uint32_t> >(threads));
+    std::vector<CodeSet> seen(threads);
+    std::vector<std::vector<Ply> > counts(threads, std::vector<Ply>(plies.size(), Ply()));
+    frontier[CodeSet::owner(root.encode(), threads)].push_back(root.encode());
+
+    for (int ply = 0; ply <= depth; ++ply) {
+        // Count the positions of the ply and play every move from them.
+        onThreads(threads, [&](int self) {
+            Ply &here = counts[self][ply];
+            for (std::uint32_t code : frontier[self]) {
+                const Piezas game = Piezas::decode(code);
+                ++here.nodes;
+                if (countOutcome(game, here) || ply == depth)
+                    continue;
+                for (int col = 0; col < BOARD_COLS; ++col) {
+                    Piezas child = game;
+                    if (child.dropPiece(col) == Blank)
+                        ++counts[self][ply + 1].lostTurns;
+                    const std::uint32_t child_code = child.encode();
+                    outbox[self][CodeSet::owner(child_code, threads)].push_back(child_code);
+                }
+            }
+        });
+        if (ply == depth)
+            break;
+
+        // Every thread merges the codes sent to it into the next ply.
+        onThreads(threads, [&](int self) {
+            seen[self].clear();
+            frontier[self].clear();
+            for (int from = 0; from < threads; ++from) {
+                for (std::uint32_t code : outbox[from][self]) {
+                    if (seen[self].insert(code))
+                        frontier[self].push_back(code);
+                }
+                outbox[from][self].clear();
+            }
+        });
+    }
+
+    for (const std::vector<Ply> &part : counts) {
+        addPlies(plies, part);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef _PERFT_H_
+#define _PERFT_H_
+#include "Piezas.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Counts the positions of the game tree ply by ply, as an exact check of
+ * the rules and of any faster board, in the way chess programs use perft.
+ *
+ * Every position which is not over has one move for each column of the
+ * board, played like dropPiece, so a drop into a full column is a move too
+ * and loses the turn. A finished game is counted but not played on.
+ *
+ * In TREE mode every sequence of moves is a node of its own. The tree is
+ * cut at the ply where there are enough positions to keep every thread
+ * busy, and the threads take the subtrees below that ply one at a time.
+ * In MERGE mode the positions of each ply are first merged by their
+ * encoding, so every distinct position is counted, and played on, once.
+ * The threads expand a share of the ply each and pass every new position
+ * to the thread which owns its hash, which keeps it in a hash set of its
+ * own.
+**/
+class Perft
+{
+  public:
+  	enum Mode
+  	{
+  	  	TREE,
+  	  	MERGE_DUPLICATES
+  	};
+
+  	/**
+  	 * The counts of one ply.
+  	**/
+  	struct Ply
+  	{
+  	  	std::uint64_t nodes;
+  	  	// Nodes where the game is over, by outcome.
+  	  	std::uint64_t xWins;
+  	  	std::uint64_t oWins;
+  	  	std::uint64_t ties;
+  	  	// Moves into this ply which dropped into a full column.
+  	  	std::uint64_t lostTurns;
+  	};
+
+  	struct Result
+  	{
+  	  	// Ply 0 is the starting position.
+  	  	std::vector<Ply> plies;
+  	  	std::uint64_t nodes;
+  	  	double seconds;
+  	  	int threads;
+
+  	  	double nodesPerSecond() const { return seconds > 0 ? nodes / seconds : 0; }
+  	  	double nodesPerSecondPerThread() const { return threads > 0 ? nodesPerSecond() / threads : 0; }
+  	};
+
+  	/**
+  	 * Constructor sets up counting on the given number of threads, or on
+  	 * one thread per core if "threads" is not positive.
+  	**/
+  	explicit Perft(int threads = 0, Mode mode = TREE);
+
+  	int threadCount() const { return threads; }
+
+  	/**
+  	 * Counts the plies from "root" down to "depth" moves deep.
+  	**/
+  	Result run(const Piezas &root, int depth) const;
+
+  private:
+  	int threads;
+  	Mode mode;
+
+  	void runTree(const Piezas &root, int depth, std::vector<Ply> &plies) const;
+  	void runMerged(const Piezas &root, int depth, std::vector<Ply> &plies) const;
+};
+
+#endif /*_PERFT_H_*/
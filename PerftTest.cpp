@@ -0,0 +1,102 @@
+/**
+ * Unit Tests for Perft
+**/
+
+#include <gtest/gtest.h>
+#include "Perft.h"
+#include <set>
+
+namespace
+{
+    bool samePlies(const Perft::Result &a, const Perft::Result &b)
+    {
+        if (a.plies.size() != b.plies.size())
+            return false;
+        for (std::size_t i = 0; i < a.plies.size(); ++i) {
+            const Perft::Ply &p = a.plies[i];
+            const Perft::Ply &q = b.plies[i];
+            if (p.nodes != q.nodes || p.xWins != q.xWins || p.oWins != q.oWins || p.ties != q.ties
+                || p.lostTurns != q.lostTurns)
+                return false;
+        }
+        return true;
+    }
+}
+
+
+TEST(PerftTest, tree_counts_match_known_values)
+{
+    // This test checks the tree counts from the empty board against the values worked
+    // out for the rules: four moves from every position, and a drop into a full
+    // column from the fourth ply on.
+    const Perft::Result result = Perft(1).run(Piezas(), 9);
+    const std::uint64_t nodes[] = { 1, 4, 16, 64, 256, 1024, 4096, 16384, 65536, 262144 };
+    const std::uint64_t lost_turns[] = { 0, 0, 0, 0, 4, 52, 424, 2776, 15964, 84268 };
+    ASSERT_EQ(result.plies.size(), 10u);
+    for (int ply = 0; ply <= 9; ++ply) {
+        ASSERT_EQ(result.plies[ply].nodes, nodes[ply]);
+        ASSERT_EQ(result.plies[ply].lostTurns, lost_turns[ply]);
+        ASSERT_EQ(result.plies[ply].xWins + result.plies[ply].oWins + result.plies[ply].ties, 0u);
+    }
+    ASSERT_EQ(result.nodes, 349525u);
+    ASSERT_EQ(result.threads, 1);
+}
+
+
+TEST(PerftTest, merged_counts_distinct_positions)
+{
+    // This test checks the merged counts against sets of positions built ply by ply
+    // with dropPiece, and that the first finished games are the full boards with six
+    // pieces of each player.
+    const Perft::Result merged = Perft(1, Perft::MERGE_DUPLICATES).run(Piezas(), 12);
+    const Perft::Result tree = Perft(1).run(Piezas(), 6);
+
+    std::set<std::uint32_t> ply_codes;
+    ply_codes.insert(Piezas().encode());
+    for (int ply = 0; ply <= 12; ++ply) {
+        std::uint64_t finished = 0;
+        std::set<std::uint32_t> next;
+        for (std::uint32_t code : ply_codes) {
+            if (Piezas::decode(code).gameState() != Invalid) {
+                ++finished;
+                continue;
+            }
+            for (int col = 0; col < BOARD_COLS; ++col) {
+                Piezas game = Piezas::decode(code);
+                game.dropPiece(col);
+                next.insert(game.encode());
+            }
+        }
+
+        const Perft::Ply &counts = merged.plies[ply];
+        ASSERT_EQ(counts.nodes, ply_codes.size());
+        ASSERT_EQ(counts.xWins + counts.oWins + counts.ties, finished);
+        if (ply <= 6) {
+            ASSERT_LE(counts.nodes, tree.plies[ply].nodes);
+        }
+        ply_codes.swap(next);
+    }
+
+    const Perft::Ply &full = merged.plies[12];
+    ASSERT_GT(full.xWins + full.oWins + full.ties, 0u);
+    ASSERT_EQ(full.xWins, full.oWins);
+    ASSERT_EQ(merged.plies[11].xWins + merged.plies[11].oWins + merged.plies[11].ties, 0u);
+}
+
+
+TEST(PerftTest, threads_agree)
+{
+    // This test counts with one and with three threads in both modes and checks that
+    // the counts are the same.
+    ASSERT_TRUE(samePlies(Perft(1).run(Piezas(), 8), Perft(3).run(Piezas(), 8)));
+    const Perft::Result one = Perft(1, Perft::MERGE_DUPLICATES).run(Piezas(), 16);
+    const Perft::Result three = Perft(3, Perft::MERGE_DUPLICATES).run(Piezas(), 16);
+    ASSERT_TRUE(samePlies(one, three));
+    ASSERT_EQ(three.threads, 3);
+    ASSERT_GT(three.plies[16].xWins + three.plies[16].oWins + three.plies[16].ties, 0u);
+
+    Piezas started;
+    started.dropPiece(1);
+    started.dropPiece(1);
+    ASSERT_TRUE(samePlies(Perft(1).run(started, 7), Perft(2).run(started, 7)));
+}
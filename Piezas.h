@@ -1,6 +1,32 @@
 #ifndef _PIEZAS_H_
 #define _PIEZAS_H_
-#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+#include <cstddef>
+#include <functional>
+
+// Asks the compiler to unroll the loop which follows completely. Loops over
+// the board size have a trip count known at compile time. Unoptimized builds
+// do not unroll anything, and GCC warns about the request there.
+#if defined(__clang__)
+#define PIEZAS_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__) && defined(__OPTIMIZE__)
+#define PIEZAS_UNROLL _Pragma("GCC unroll 64")
+#else
+#define PIEZAS_UNROLL
+#endif
+
+// Building with PIEZAS_INSTRUMENT defined times the public methods and
+// counts what they return, see PiezasInstrument.h. Otherwise the
+// instrumentation is left out completely.
+#ifdef PIEZAS_INSTRUMENT
+#include "PiezasInstrument.h"
+#else
+#define PIEZAS_INSTRUMENT_TIME(method)
+#define PIEZAS_INSTRUMENT_RESULT(method, piece)
+#define PIEZAS_INSTRUMENT_CALLS(method, calls)
+#endif
 
 const int BOARD_ROWS = 3;
 const int BOARD_COLS = 4;
@@ -14,6 +40,281 @@ enum Piece
 };
 
 
+/**
+ * Bit layout of a Piezas board with the given number of rows and columns.
+ * Cell [row,col] is bit (row * Cols + col) of a Mask, which is the smallest
+ * unsigned integer type with a bit for every cell.
+**/
+template <int Rows, int Cols>
+struct PiezasGeometry
+{
+  	static_assert(Rows > 0 && Cols > 0, "a board needs at least one cell");
+  	static_assert(Rows * Cols <= 64, "every cell of the board needs a bit in a 64-bit mask");
+
+  	static constexpr int CELLS = Rows * Cols;
+
+  	typedef typename std::conditional<(CELLS <= 8), std::uint8_t,
+  	        typename std::conditional<(CELLS <= 16), std::uint16_t,
+  	        typename std::conditional<(CELLS <= 32), std::uint32_t,
+  	        std::uint64_t>::type>::type>::type Mask;
+
+  	// Boards up to this many cells get a table with the winner of every full board.
+  	static constexpr int TABULATED_CELLS = 12;
+
+  	/**
+  	 * The winner of every full board, indexed by the cells which hold an X.
+  	**/
+  	struct OutcomeTable
+  	{
+  	  	unsigned char winner[1u << (CELLS <= TABULATED_CELLS ? CELLS : 0)];
+  	};
+
+  	/**
+  	 * Returns a mask with every cell of the board set.
+  	**/
+  	static constexpr Mask fullBoard()
+  	{
+  	  	return static_cast<Mask>(static_cast<Mask>(~Mask(0)) >> (8 * sizeof(Mask) - CELLS));
+  	}
+
+  	/**
+  	 * Returns a mask with the cells of column 0 set. Shift it left by the
+  	 * column number for any other column.
+  	**/
+  	static constexpr Mask columnZero()
+  	{
+  	  	Mask mask = 0;
+  	  	for (int row = 0; row < Rows; ++row) {
+  	  	  	mask |= Mask(1) << (row * Cols);
+  	  	}
+  	  	return mask;
+  	}
+
+  	/**
+  	 * Returns the bit which represents the cell at [row,col].
+  	**/
+  	static constexpr Mask cellBit(int row, int column)
+  	{
+  	  	return Mask(1) << (row * Cols + column);
+  	}
+
+  	/**
+  	 * Returns the column which mirrors the given column, the board being
+  	 * symmetric from left to right.
+  	**/
+  	static constexpr int mirrorColumn(int column)
+  	{
+  	  	return Cols - 1 - column;
+  	}
+
+  	/**
+  	 * Returns the mask mirrored from left to right: every column c moves
+  	 * to column Cols - 1 - c. Each pair of mirrored columns is swapped
+  	 * with two shifts.
+  	**/
+  	static constexpr Mask mirror(Mask mask)
+  	{
+  	  	Mask mirrored = (Cols % 2) ? static_cast<Mask>(mask & (columnZero() << (Cols / 2))) : Mask(0);
+  	  	PIEZAS_UNROLL
+  	  	for (int col = 0; col < Cols / 2; ++col) {
+  	  	  	const int distance = Cols - 1 - 2 * col;
+  	  	  	mirrored |= static_cast<Mask>((mask & (columnZero() << col)) << distance);
+  	  	  	mirrored |= static_cast<Mask>((mask >> distance) & (columnZero() << col));
+  	  	}
+  	  	return mirrored;
+  	}
+
+  	/**
+  	 * Returns the number of the cell (row * Cols + col) represented by a
+  	 * mask with exactly one bit set.
+  	**/
+  	static int cellIndex(Mask bit)
+  	{
+#if defined(__GNUC__)
+  	  	return __builtin_ctzll(bit);
+#else
+  	  	int index = 0;
+  	  	while (!(bit & 1)) {
+  	  	  	bit >>= 1;
+  	  	  	++index;
+  	  	}
+  	  	return index;
+#endif
+  	}
+
+  	/**
+  	 * Returns the number of bits set in a mask.
+  	**/
+  	static int popCount(Mask mask)
+  	{
+#if defined(__GNUC__)
+  	  	return __builtin_popcountll(mask);
+#else
+  	  	int count = 0;
+  	  	for (; mask; mask &= static_cast<Mask>(mask - 1)) {
+  	  	  	++count;
+  	  	}
+  	  	return count;
+#endif
+  	}
+
+  	/**
+  	 * Returns the column tried i-th when searching moves: the middle column
+  	 * first, then alternating outwards, because columns nearer the middle
+  	 * take part in more lines. For 4 columns the order is 1, 2, 0, 3.
+  	**/
+  	static constexpr int orderedColumn(int i)
+  	{
+  	  	return (Cols - 1) / 2 + ((i % 2) ? (i + 1) / 2 : -((i + 1) / 2));
+  	}
+
+  	/**
+  	 * Returns the length of the longest horizontal or vertical line of
+  	 * set bits in the given mask.
+  	**/
+  	static constexpr int longestLine(Mask mask)
+  	{
+  	  	// After k rounds, a bit is set in "horizontal" if a line of k + 1 pieces
+  	  	// starts at that cell and runs to the right, and in "vertical" if such a
+  	  	// line runs upwards. Lines may not wrap around from one row to the next,
+  	  	// so "starts" tracks the cells which are far enough from the right edge.
+  	  	// The number of rounds only depends on the board size, so the loop is
+  	  	// unrolled completely.
+  	  	Mask horizontal = mask;
+  	  	Mask vertical = mask;
+  	  	Mask starts = fullBoard();
+  	  	int length = (mask != 0) ? 1 : 0;
+
+  	  	PIEZAS_UNROLL
+  	  	for (int k = 1; k < Cols || k < Rows; ++k) {
+  	  	  	starts &= static_cast<Mask>(~(columnZero() << (Cols > k ? Cols - k : 0)));
+  	  	  	horizontal &= static_cast<Mask>((mask >> k) & starts);
+  	  	  	vertical &= static_cast<Mask>(k < Rows ? mask >> (k * Cols) : 0);
+  	  	  	length += (horizontal | vertical) != 0;
+  	  	}
+
+  	  	return length;
+  	}
+
+  	/**
+  	 * Returns the winner of a full board, given which of its cells hold an X.
+  	**/
+  	static constexpr Piece fullBoardWinner(Mask xs)
+  	{
+  	  	const int X_counter_max = longestLine(xs);
+  	  	const int O_counter_max = longestLine(static_cast<Mask>(fullBoard() & ~xs));
+
+  	  	if (O_counter_max == X_counter_max) {
+  	  	  	return Blank;
+  	  	} else if (O_counter_max > X_counter_max) {
+  	  	  	return O;
+  	  	} else {
+  	  	  	return X;
+  	  	}
+  	}
+
+  	/**
+  	 * Builds the OutcomeTable. Only valid for boards of at most TABULATED_CELLS.
+  	**/
+  	static constexpr OutcomeTable makeOutcomeTable()
+  	{
+  	  	OutcomeTable table = {};
+  	  	for (std::uint32_t xs = 0; xs < sizeof(table.winner); ++xs) {
+  	  	  	table.winner[xs] = fullBoardWinner(static_cast<Mask>(xs));
+  	  	}
+  	  	return table;
+  	}
+};
+
+
+/**
+ * Answers who won a full board. Boards which are small enough look the
+ * answer up in an OutcomeTable generated at compile time, larger boards
+ * work it out from the masks.
+**/
+template <int Rows, int Cols,
+          bool Tabulated = (Rows * Cols <= PiezasGeometry<Rows, Cols>::TABULATED_CELLS)>
+struct PiezasOutcomes
+{
+  	typedef PiezasGeometry<Rows, Cols> Geometry;
+
+  	static Piece fullBoardWinner(typename Geometry::Mask xs)
+  	{
+  	  	return Geometry::fullBoardWinner(xs);
+  	}
+};
+
+template <int Rows, int Cols>
+struct PiezasOutcomes<Rows, Cols, true>
+{
+  	typedef PiezasGeometry<Rows, Cols> Geometry;
+
+  	static constexpr typename Geometry::OutcomeTable TABLE = Geometry::makeOutcomeTable();
+
+  	static Piece fullBoardWinner(typename Geometry::Mask xs)
+  	{
+  	  	return static_cast<Piece>(TABLE.winner[xs]);
+  	}
+};
+
+template <int Rows, int Cols>
+constexpr typename PiezasGeometry<Rows, Cols>::OutcomeTable PiezasOutcomes<Rows, Cols, true>::TABLE;
+
+
+/**
+ * Random 64-bit keys for Zobrist hashing of a board: one for an X and one
+ * for an O on every cell, and one for O being the player to move. The hash
+ * of a position is the exclusive or of the keys of everything on it. The
+ * keys come from a fixed splitmix64 sequence, so hashes are the same in
+ * every build and every run.
+**/
+template <int Rows, int Cols>
+struct PiezasZobrist
+{
+  	struct Keys
+  	{
+  	  	std::uint64_t X_cells[Rows * Cols];
+  	  	std::uint64_t O_cells[Rows * Cols];
+  	  	std::uint64_t O_to_move;
+
+  	  	// The keys of the mirrored cell, [row,Cols-1-col] for [row,col], so
+  	  	// the hash of the mirrored position can be kept up to date as well.
+  	  	std::uint64_t X_mirrored[Rows * Cols];
+  	  	std::uint64_t O_mirrored[Rows * Cols];
+  	};
+
+  	static constexpr std::uint64_t splitmix64(std::uint64_t &state)
+  	{
+  	  	std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+  	  	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  	  	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  	  	return z ^ (z >> 31);
+  	}
+
+  	static constexpr Keys makeKeys()
+  	{
+  	  	Keys keys = {};
+  	  	std::uint64_t state = 0x5069657A6173ull + Rows * 64 + Cols;
+  	  	for (int cell = 0; cell < Rows * Cols; ++cell) {
+  	  	  	keys.X_cells[cell] = splitmix64(state);
+  	  	  	keys.O_cells[cell] = splitmix64(state);
+  	  	}
+  	  	keys.O_to_move = splitmix64(state);
+  	  	for (int cell = 0; cell < Rows * Cols; ++cell) {
+  	  	  	const int mirrored = cell - cell % Cols + (Cols - 1 - cell % Cols);
+  	  	  	keys.X_mirrored[cell] = keys.X_cells[mirrored];
+  	  	  	keys.O_mirrored[cell] = keys.O_cells[mirrored];
+  	  	}
+  	  	return keys;
+  	}
+
+  	static constexpr Keys KEYS = makeKeys();
+};
+
+template <int Rows, int Cols>
+constexpr typename PiezasZobrist<Rows, Cols>::Keys PiezasZobrist<Rows, Cols>::KEYS;
+
+
 /**
  * Class for representing a Piezas vertical board, which is roughly based
  * on the game "Connect Four" where pieces are placed in a column and
@@ -27,19 +328,88 @@ enum Piece
  * [0,0][0,1][0,2][0,3]
  * So that a piece dropped in column 2 should take [0,2] and the next one
  * dropped in column 2 should take [1,2].
+ *
+ * The board size is fixed at compile time. Piezas is the default board of
+ * BOARD_ROWS rows and BOARD_COLS columns.
 **/
-class Piezas
+template <int Rows, int Cols>
+class BasicPiezas
 {
+  public:
+  	typedef PiezasGeometry<Rows, Cols> Geometry;
+  	typedef typename Geometry::Mask Mask;
+
+  	static constexpr int ROWS = Rows;
+  	static constexpr int COLS = Cols;
+
+  	/**
+  	 * What a move did to the board, returned by makeMove so that
+  	 * unmakeMove can take the move back.
+  	**/
+  	struct Move
+  	{
+  	  	// What dropPiece would have returned for the move.
+  	  	Piece piece;
+  	  	// The cell the piece landed on, or 0 if no piece was placed.
+  	  	Mask landing;
+  	};
+
   private:
-  	std::vector < std::vector<Piece> > board;
+  	// The board is stored as two bitboards, laid out as described by
+  	// PiezasGeometry. "occupied" has a bit set for every cell holding a
+  	// piece, and "xs" has a bit set for every cell holding an X. A cell that
+  	// is occupied but not in "xs" holds an O.
+  	Mask occupied;
+  	Mask xs;
   	Piece turn;
 
+  	// The number of pieces on the board, kept up to date by dropPiece so that
+  	// gameState can tell whether the board is full without looking at it.
+  	int filled;
+
+  	// The Zobrist hash of the cells and the player to move, see PiezasZobrist,
+  	// and the hash the mirrored position would have. Every move updates them
+  	// with one or two exclusive ors each.
+  	std::uint64_t zobrist;
+  	std::uint64_t mirrored_zobrist;
+
+  	typedef PiezasZobrist<Rows, Cols> Zobrist;
+
+  	/**
+  	 * Computes gameState by scanning the whole board instead of looking the
+  	 * answer up in the table of full boards. With
+  	 * PIEZAS_DEBUG_GAMESTATE defined, gameState checks its answer against it.
+  	**/
+  	Piece scanGameState() const;
+
+  	/**
+  	 * Sets "filled" and the hashes from the bitboards and the turn.
+  	**/
+  	void rehash();
+
+  	/**
+  	 * The loop of applyMoves, with the results stored or not.
+  	**/
+  	template <bool StoreResults>
+  	std::size_t applyMoveLoop(const int *columns, std::size_t n, Piece *results);
+
+  	/**
+  	 * Returns whether the mirror image is the canonical form of the position.
+  	**/
+  	bool mirrorIsCanonical() const
+  	{
+  	  	const Mask mirrored_occupied = Geometry::mirror(occupied);
+  	  	if (mirrored_occupied != occupied)
+  	  	  	return mirrored_occupied < occupied;
+  	  	return Geometry::mirror(xs) < xs;
+  	}
+
   public:
   	/**
-     * Constructor sets an empty board (3 rows, 4 columns) and
+     * Constructor sets an empty board (Rows rows, Cols columns) and
      * specifies it is X's turn first
     **/
-  	Piezas();
+  	BasicPiezas();
 
   	/**
      * Resets each board location to the Blank Piece value, with a board of the
@@ -57,11 +427,36 @@ class Piezas
   	**/
   	Piece dropPiece(int column);
 
+  	/**
+  	 * Plays a move exactly like dropPiece, and returns what it did so that
+  	 * it can be taken back with unmakeMove.
+  	**/
+  	Move makeMove(int column);
+
+  	/**
+  	 * Takes back a move returned by makeMove, restoring the board, the turn
+  	 * and everything kept up to date with them, including after a move which
+  	 * lost the turn. Moves have to be taken back in the reverse order they
+  	 * were made.
+  	**/
+  	void unmakeMove(const Move &move);
+
+  	/**
+  	 * Plays the columns of "columns" one after another, exactly like n
+  	 * calls to dropPiece, and stores what each call would have returned in
+  	 * "results" unless it is null. Stops after the move which fills the
+  	 * board, or straight away if it is full already, and returns the
+  	 * number of moves played; the rest are left out of "results". With
+  	 * PIEZAS_INSTRUMENT, every move counts as a dropPiece call with its
+  	 * result, but the moves are not timed.
+  	**/
+  	std::size_t applyMoves(const int *columns, std::size_t n, Piece *results = nullptr);
+
   	/**
   	 * Returns what piece is at the provided coordinates, or Blank if there
   	 * are no pieces there, or Invalid if the coordinates are out of bounds
   	**/
-  	Piece pieceAt(int row, int column);
+  	Piece pieceAt(int row, int column) const;
 
     /**
      * Returns which Piece has won, if there is a winner, Invalid if the game
@@ -72,7 +467,558 @@ class Piezas
      * or horizontally. If both X's and O's have the same number of pieces in a
      * line, it is a tie.
     **/
-  	Piece gameState();
+  	Piece gameState() const;
+
+  	/**
+  	 * Returns whose turn it is to place a piece.
+  	**/
+  	Piece currentTurn() const { return turn; }
+
+  	/**
+  	 * Returns the bitboard of the cells holding a piece, laid out as
+  	 * described by PiezasGeometry.
+  	**/
+  	Mask occupiedMask() const { return occupied; }
+
+  	/**
+  	 * Returns the bitboard of the cells holding an X, laid out as described
+  	 * by PiezasGeometry.
+  	**/
+  	Mask xMask() const { return xs; }
+
+  	/**
+  	 * Returns the columns which are not full yet as a bitmask, bit c being
+  	 * set if column c is open. Dropping into any other column of the board
+  	 * places nothing and loses the turn.
+  	**/
+  	Mask legalMoves() const
+  	{
+  	  	// A column is open while its top cell is free.
+  	  	return static_cast<Mask>(static_cast<Mask>(~occupied) >> ((Rows - 1) * Cols)
+  	  	                         & (Geometry::fullBoard() >> ((Rows - 1) * Cols)));
+  	}
+
+  	/**
+  	 * Returns the number of pieces in the given column, which is also the
+  	 * row the next piece dropped into it lands on, or -1 if the column is
+  	 * out of bounds.
+  	**/
+  	int columnHeight(int column) const
+  	{
+  	  	if (column < 0 || column >= Cols)
+  	  	  	return -1;
+  	  	return Geometry::popCount(static_cast<Mask>(occupied & (Geometry::columnZero() << column)));
+  	}
+
+  	/**
+  	 * Returns the number of pieces on the board.
+  	**/
+  	int filledCount() const { return filled; }
+
+  	/**
+  	 * Returns whether every cell of the board holds a piece.
+  	**/
+  	bool isFull() const { return filled == Geometry::CELLS; }
+
+  	/**
+  	 * Writes the open columns to "columns" in the order a search should try
+  	 * them (see PiezasGeometry::orderedColumn), and returns how many there
+  	 * are.
+  	**/
+  	int orderedLegalMoves(int columns[Cols]) const
+  	{
+  	  	const Mask open = legalMoves();
+  	  	int count = 0;
+  	  	PIEZAS_UNROLL
+  	  	for (int i = 0; i < Cols; ++i) {
+  	  	  	const int column = Geometry::orderedColumn(i);
+  	  	  	columns[count] = column;
+  	  	  	count += static_cast<int>((open >> column) & 1);
+  	  	}
+  	  	return count;
+  	}
+
+  	/**
+  	 * Returns a 64-bit Zobrist hash of the pieces on the board and the
+  	 * player to move. Equal positions have equal hashes.
+  	**/
+  	std::uint64_t hash() const { return zobrist; }
+
+  	/**
+  	 * The position which stands for a position and its mirror image, see
+  	 * canonical().
+  	**/
+  	struct Canonical
+  	{
+  	  	// The canonical position: the original or its mirror image.
+  	  	BasicPiezas position;
+  	  	// Whether "position" is the mirror image of the original.
+  	  	bool mirrored;
+
+  	  	/**
+  	  	 * Returns the hash of the canonical position.
+  	  	**/
+  	  	std::uint64_t hash() const { return position.hash(); }
+
+  	  	/**
+  	  	 * Maps a column of the original position to the same column of the
+  	  	 * canonical position. Mirroring is its own inverse, so this also maps
+  	  	 * columns of the canonical position back to the original.
+  	  	**/
+  	  	int column(int column) const
+  	  	{
+  	  	  	return mirrored ? Geometry::mirrorColumn(column) : column;
+  	  	}
+  	};
+
+  	/**
+  	 * Returns the position mirrored from left to right, where column c
+  	 * becomes column Cols - 1 - c. It has the same player to move and the
+  	 * same gameState.
+  	**/
+  	BasicPiezas mirrored() const;
+
+  	/**
+  	 * Returns the canonical form of the position, which is the same for a
+  	 * position and its mirror image: whichever of the two has the smaller
+  	 * (occupied, xs) masks. Solvers and caches which store canonical
+  	 * positions only need to store half of them.
+  	**/
+  	Canonical canonical() const;
+
+  	/**
+  	 * Returns the hash of canonical().position without building it.
+  	**/
+  	std::uint64_t canonicalHash() const
+  	{
+  	  	return mirrorIsCanonical() ? mirrored_zobrist : zobrist;
+  	}
+
+  	/**
+  	 * Packs the position into 32 bits: the occupied mask in the low CELLS
+  	 * bits, the X mask in the next CELLS bits, and a set bit above them if
+  	 * it is O's turn. Only for boards of up to 15 cells.
+  	**/
+  	template <int Cells = Rows * Cols>
+  	std::uint32_t encode() const
+  	{
+  	  	static_assert(2 * Cells + 1 <= 32, "the position has to fit in 32 bits");
+  	  	return std::uint32_t(occupied)
+  	  	     | (std::uint32_t(xs) << Cells)
+  	  	     | (std::uint32_t(turn == O) << (2 * Cells));
+  	}
+
+  	/**
+  	 * Returns whether a 32-bit code is the encoding of a position: no bits
+  	 * above the turn are set, every X is on an occupied cell, and the pieces
+  	 * of every column are stacked from row 0 up.
+  	**/
+  	template <int Cells = Rows * Cols>
+  	static bool isValidCode(std::uint32_t code)
+  	{
+  	  	static_assert(2 * Cells + 1 <= 32, "the position has to fit in 32 bits");
+  	  	const Mask occupied = static_cast<Mask>(code & Geometry::fullBoard());
+  	  	const Mask xs = static_cast<Mask>((code >> Cells) & Geometry::fullBoard());
+  	  	// A piece above row 0 needs a piece below it.
+  	  	const Mask row_zero = static_cast<Mask>(Geometry::fullBoard() >> ((Rows - 1) * Cols));
+  	  	const Mask supported = static_cast<Mask>((occupied << Cols) | row_zero);
+  	  	return (code >> (2 * Cells + 1)) == 0 && (xs & ~occupied) == 0 && (occupied & ~supported) == 0;
+  	}
+
+  	/**
+  	 * Returns the position packed by encode(). The code has to be valid,
+  	 * see isValidCode.
+  	**/
+  	template <int Cells = Rows * Cols>
+  	static BasicPiezas decode(std::uint32_t code)
+  	{
+  	  	static_assert(2 * Cells + 1 <= 32, "the position has to fit in 32 bits");
+  	  	BasicPiezas game;
+  	  	game.occupied = static_cast<Mask>(code & Geometry::fullBoard());
+  	  	game.xs = static_cast<Mask>((code >> Cells) & game.occupied);
+  	  	game.turn = ((code >> (2 * Cells)) & 1) ? O : X;
+  	  	game.rehash();
+  	  	return game;
+  	}
+
+  	/**
+  	 * Two positions are equal if they have the same pieces on the same
+  	 * cells and the same player to move.
+  	**/
+  	bool operator==(const BasicPiezas &other) const
+  	{
+  	  	return occupied == other.occupied && xs == other.xs && turn == other.turn;
+  	}
+
+  	bool operator!=(const BasicPiezas &other) const
+  	{
+  	  	return !(*this == other);
+  	}
 };
 
+template <int Rows, int Cols>
+constexpr int BasicPiezas<Rows, Cols>::ROWS;
+
+template <int Rows, int Cols>
+constexpr int BasicPiezas<Rows, Cols>::COLS;
+
+/**
+ * The default 3 row, 4 column board.
+**/
+typedef BasicPiezas<BOARD_ROWS, BOARD_COLS> Piezas;
+
+
+/**
+ * Constructor sets an empty board (Rows rows, Cols columns) and
+ * specifies it is X's turn first
+**/
+template <int Rows, int Cols>
+BasicPiezas<Rows, Cols>::BasicPiezas()
+{
+    // set an empty board
+    occupied = 0;
+    xs = 0;
+    filled = 0;
+
+    // specify it is X's turn first
+    turn = X;
+    zobrist = 0;
+    mirrored_zobrist = 0;
+}
+
+/**
+ * Resets each board location to the Blank Piece value, with a board of the
+ * same size as previously specified
+**/
+template <int Rows, int Cols>
+void BasicPiezas<Rows, Cols>::reset()
+{
+    PIEZAS_INSTRUMENT_TIME(RESET);
+
+    // set an empty board
+    occupied = 0;
+    xs = 0;
+    filled = 0;
+
+    // Only the player to move is left in the hash.
+    zobrist = (turn == O) ? Zobrist::KEYS.O_to_move : 0;
+    mirrored_zobrist = zobrist;
+}
+
+/**
+ * Places a piece of the current turn on the board, returns what
+ * piece is placed, and toggles which Piece's turn it is. dropPiece does
+ * NOT allow to place a piece in a location where a column is full.
+ * In that case, placePiece returns Piece Blank value
+ * Out of bounds coordinates return the Piece Invalid value
+ * Trying to drop a piece where it cannot be placed loses the player's turn
+**/
+template <int Rows, int Cols>
+Piece BasicPiezas<Rows, Cols>::dropPiece(int column)
+{
+    PIEZAS_INSTRUMENT_TIME(DROP_PIECE);
+    const Piece piece = makeMove(column).piece;
+    PIEZAS_INSTRUMENT_RESULT(DROP_PIECE, piece);
+    return piece;
+}
+
+/**
+ * Plays the columns of "columns" one after another, exactly like n
+ * calls to dropPiece, and stores what each call would have returned in
+ * "results" unless it is null. Stops after the move which fills the
+ * board, or straight away if it is full already, and returns the
+ * number of moves played; the rest are left out of "results". With
+ * PIEZAS_INSTRUMENT, every move counts as a dropPiece call with its
+ * result, but the moves are not timed.
+**/
+template <int Rows, int Cols>
+std::size_t BasicPiezas<Rows, Cols>::applyMoves(const int *columns, std::size_t n, Piece *results)
+{
+    return results ? applyMoveLoop<true>(columns, n, results) : applyMoveLoop<false>(columns, n, results);
+}
+
+/**
+ * The loop of applyMoves, with the results stored or not. The position is
+ * kept in locals for the whole sequence and written back once, and the
+ * hashes take the turn into account once at the end.
+**/
+template <int Rows, int Cols>
+template <bool StoreResults>
+std::size_t BasicPiezas<Rows, Cols>::applyMoveLoop(const int *columns, std::size_t n, Piece *results)
+{
+    Mask board = occupied;
+    Mask x_cells = xs;
+    bool x_to_move = (turn == X);
+    int pieces = filled;
+    std::uint64_t hash = zobrist;
+    std::uint64_t mirrored_hash = mirrored_zobrist;
+
+    std::size_t played = 0;
+    while (played < n && pieces < Rows * Cols) {
+        const int column = columns[played];
+        Piece piece = Invalid;
+        if (column >= 0 && column < Cols) {
+            const Mask free_cells = static_cast<Mask>(~board & (Geometry::columnZero() << column));
+            piece = Blank;
+            if (free_cells != 0) {
+                const Mask landing = static_cast<Mask>(free_cells & (0 - free_cells));
+                const int cell = Geometry::cellIndex(landing);
+                board |= landing;
+                ++pieces;
+                if (x_to_move) {
+                    x_cells |= landing;
+                    hash ^= Zobrist::KEYS.X_cells[cell];
+                    mirrored_hash ^= Zobrist::KEYS.X_mirrored[cell];
+                    piece = X;
+                } else {
+                    hash ^= Zobrist::KEYS.O_cells[cell];
+                    mirrored_hash ^= Zobrist::KEYS.O_mirrored[cell];
+                    piece = O;
+                }
+            }
+        }
+        if (StoreResults)
+            results[played] = piece;
+        PIEZAS_INSTRUMENT_RESULT(DROP_PIECE, piece);
+        x_to_move = !x_to_move;
+        ++played;
+    }
+    PIEZAS_INSTRUMENT_CALLS(DROP_PIECE, played);
+
+    // Every move toggled the turn.
+    if (played % 2) {
+        hash ^= Zobrist::KEYS.O_to_move;
+        mirrored_hash ^= Zobrist::KEYS.O_to_move;
+    }
+    occupied = board;
+    xs = x_cells;
+    turn = x_to_move ? X : O;
+    filled = pieces;
+    zobrist = hash;
+    mirrored_zobrist = mirrored_hash;
+    return played;
+}
+
+/**
+ * Plays a move exactly like dropPiece, and returns what it did so that
+ * it can be taken back with unmakeMove.
+**/
+template <int Rows, int Cols>
+typename BasicPiezas<Rows, Cols>::Move BasicPiezas<Rows, Cols>::makeMove(int column)
+{
+    Move move = { Blank, 0 };
+
+    // Out of bounds coordinates
+    if (column < 0 || column >= Cols) {
+        move.piece = Invalid;
+    // Inside bounds coordinates
+    } else {
+        // Pieces stack up from row 0, so the free cells of a column are always
+        // the top ones, and the lowest free cell is where the piece lands.
+        const Mask free_cells = static_cast<Mask>(~occupied & (Geometry::columnZero() << column));
+
+        if (free_cells != 0) {
+            move.landing = static_cast<Mask>(free_cells & (0 - free_cells));
+            occupied |= move.landing;
+            ++filled;
+            const int cell = Geometry::cellIndex(move.landing);
+            if (turn == X) {
+                xs |= move.landing;
+                zobrist ^= Zobrist::KEYS.X_cells[cell];
+                mirrored_zobrist ^= Zobrist::KEYS.X_mirrored[cell];
+            } else {
+                zobrist ^= Zobrist::KEYS.O_cells[cell];
+                mirrored_zobrist ^= Zobrist::KEYS.O_mirrored[cell];
+            }
+            move.piece = turn;
+        } else {
+            move.piece = Blank;
+        }
+    }
+
+    // set the turn to the other player
+    turn = (turn == X) ? O : X;
+    zobrist ^= Zobrist::KEYS.O_to_move;
+    mirrored_zobrist ^= Zobrist::KEYS.O_to_move;
+
+    return move;
+}
+
+/**
+ * Takes back a move returned by makeMove, restoring the board, the turn
+ * and everything kept up to date with them, including after a move which
+ * lost the turn. Moves have to be taken back in the reverse order they
+ * were made.
+**/
+template <int Rows, int Cols>
+void BasicPiezas<Rows, Cols>::unmakeMove(const Move &move)
+{
+    // Every move toggles the turn, whether or not it placed a piece.
+    turn = (turn == X) ? O : X;
+    zobrist ^= Zobrist::KEYS.O_to_move;
+    mirrored_zobrist ^= Zobrist::KEYS.O_to_move;
+
+    if (move.landing != 0) {
+        const int cell = Geometry::cellIndex(move.landing);
+        if (xs & move.landing) {
+            zobrist ^= Zobrist::KEYS.X_cells[cell];
+            mirrored_zobrist ^= Zobrist::KEYS.X_mirrored[cell];
+        } else {
+            zobrist ^= Zobrist::KEYS.O_cells[cell];
+            mirrored_zobrist ^= Zobrist::KEYS.O_mirrored[cell];
+        }
+        occupied &= static_cast<Mask>(~move.landing);
+        xs &= static_cast<Mask>(~move.landing);
+        --filled;
+    }
+}
+
+/**
+ * Returns what piece is at the provided coordinates, or Blank if there
+ * are no pieces there, or Invalid if the coordinates are out of bounds
+**/
+template <int Rows, int Cols>
+Piece BasicPiezas<Rows, Cols>::pieceAt(int row, int column) const
+{
+    PIEZAS_INSTRUMENT_TIME(PIECE_AT);
+    const bool row_invalid = row < 0 || row >= Rows;
+    const bool col_invalid = column < 0 || column >= Cols;
+
+    if (row_invalid || col_invalid) {
+        return Invalid;
+    } else {
+        // This can return either the piece or a Blank.
+        // By default when the board is cleared, all values are set to Blank.
+        const Mask bit = Geometry::cellBit(row, column);
+        if (!(occupied & bit))
+            return Blank;
+        return (xs & bit) ? X : O;
+    }
+}
+
+/**
+ * Returns which Piece has won, if there is a winner, Invalid if the game
+ * is not over, or Blank if the board is filled and no one has won ("tie").
+ * For a game to be over, all locations on the board must be filled with X's
+ * and O's (i.e. no remaining Blank spaces). The winner is which player has
+ * the most adjacent pieces in a single line. Lines can go either vertically
+ * or horizontally. If both X's and O's have the same max number of pieces in a
+ * line, it is a tie.
+**/
+template <int Rows, int Cols>
+Piece BasicPiezas<Rows, Cols>::gameState() const
+{
+    PIEZAS_INSTRUMENT_TIME(GAME_STATE);
+    Piece winner = Invalid;
+
+    // The game is not over while there are any Blank squares. Once the board
+    // is full, the X cells alone decide the winner.
+    if (filled < Geometry::CELLS) {
+        winner = Invalid;
+    } else {
+        winner = PiezasOutcomes<Rows, Cols>::fullBoardWinner(xs);
+    }
+
+#ifdef PIEZAS_DEBUG_GAMESTATE
+    assert(winner == scanGameState());
+#endif
+
+    PIEZAS_INSTRUMENT_RESULT(GAME_STATE, winner);
+    return winner;
+}
+
+/**
+ * Computes gameState by scanning the whole board instead of looking the
+ * answer up in the table of full boards. With
+ * PIEZAS_DEBUG_GAMESTATE defined, gameState checks its answer against it.
+**/
+template <int Rows, int Cols>
+Piece BasicPiezas<Rows, Cols>::scanGameState() const
+{
+    // Check for any Blank squares.
+    if (occupied != Geometry::fullBoard())
+        return Invalid;
+
+    // The maximum number of continuous squares for each player in the whole board.
+    const int X_counter_max = Geometry::longestLine(xs);
+    const int O_counter_max = Geometry::longestLine(static_cast<Mask>(occupied & ~xs));
+
+    // Compare the maximum counters to see who won.
+    if (O_counter_max == X_counter_max) {
+        return Blank;
+    } else if (O_counter_max > X_counter_max) {
+        return O;
+    } else {
+        return X;
+    }
+}
+
+/**
+ * Sets "filled" and the hashes from the bitboards and the turn.
+**/
+template <int Rows, int Cols>
+void BasicPiezas<Rows, Cols>::rehash()
+{
+    filled = Geometry::popCount(occupied);
+    zobrist = (turn == O) ? Zobrist::KEYS.O_to_move : 0;
+    mirrored_zobrist = zobrist;
+
+    for (int cell = 0; cell < Geometry::CELLS; ++cell) {
+        const Mask bit = static_cast<Mask>(Mask(1) << cell);
+        if (xs & bit) {
+            zobrist ^= Zobrist::KEYS.X_cells[cell];
+            mirrored_zobrist ^= Zobrist::KEYS.X_mirrored[cell];
+        } else if (occupied & bit) {
+            zobrist ^= Zobrist::KEYS.O_cells[cell];
+            mirrored_zobrist ^= Zobrist::KEYS.O_mirrored[cell];
+        }
+    }
+}
+
+/**
+ * Returns the position mirrored from left to right, where column c
+ * becomes column Cols - 1 - c. It has the same player to move and the
+ * same gameState.
+**/
+template <int Rows, int Cols>
+BasicPiezas<Rows, Cols> BasicPiezas<Rows, Cols>::mirrored() const
+{
+    BasicPiezas mirror = *this;
+    mirror.occupied = Geometry::mirror(occupied);
+    mirror.xs = Geometry::mirror(xs);
+    mirror.zobrist = mirrored_zobrist;
+    mirror.mirrored_zobrist = zobrist;
+    return mirror;
+}
+
+/**
+ * Returns the canonical form of the position, which is the same for a
+ * position and its mirror image: whichever of the two has the smaller
+ * (occupied, xs) masks. Solvers and caches which store canonical
+ * positions only need to store half of them.
+**/
+template <int Rows, int Cols>
+typename BasicPiezas<Rows, Cols>::Canonical BasicPiezas<Rows, Cols>::canonical() const
+{
+    const bool mirror = mirrorIsCanonical();
+    Canonical result = { mirror ? mirrored() : *this, mirror };
+    return result;
+}
+
+namespace std
+{
+  	/**
+  	 * Hashes a board by its Zobrist hash, so that positions can be used as
+  	 * keys of unordered containers directly.
+  	**/
+  	template <int Rows, int Cols>
+  	struct hash<BasicPiezas<Rows, Cols> >
+  	{
+  	  	std::size_t operator()(const BasicPiezas<Rows, Cols> &game) const
+  	  	{
+  	  	  	return static_cast<std::size_t>(game.hash());
+  	  	}
+  	};
+}
+
 #endif /*_PIEZAS_H_*/
@@ -0,0 +1,130 @@
+#include "PiezasBatch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIEZAS_BATCH_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    typedef Piezas::Geometry Geometry;
+    typedef Piezas::Mask Mask;
+
+    static_assert(sizeof(PackedBoard) == 2 * sizeof(Mask), "PackedBoard has no padding");
+
+#ifdef PIEZAS_BATCH_AVX2
+    static_assert(sizeof(PackedBoard) == 4, "the AVX2 kernel reads one board per 32-bit lane");
+    static_assert(sizeof(Piece) == 4, "the AVX2 kernel writes one Piece per 32-bit lane");
+
+    // The winner of every full board, as in PiezasOutcomes, followed by three
+    // bytes of padding: a gather reads four bytes at the index of each board.
+    struct PaddedOutcomes
+    {
+        unsigned char winner[Geometry::fullBoard() + 1 + 3];
+
+        constexpr PaddedOutcomes() : winner()
+        {
+            for (unsigned int xs = 0; xs <= Geometry::fullBoard(); ++xs) {
+                winner[xs] = PiezasOutcomes<BOARD_ROWS, BOARD_COLS>::TABLE.winner[xs];
+            }
+        }
+    };
+
+    constexpr PaddedOutcomes PADDED_OUTCOMES;
+
+    /**
+     * Scores eight boards per step, and the rest with the scalar code. The
+     * winners come from the same compile-time table as Piezas::gameState.
+    **/
+    __attribute__((target("avx2")))
+    void gameStateBatchAvx2(const PackedBoard *boards, Piece *out, std::size_t n)
+    {
+        const __m256i low = _mm256_set1_epi32(0xFFFF);
+        const __m256i full = _mm256_set1_epi32(Geometry::fullBoard());
+        const __m256i byte = _mm256_set1_epi32(0xFF);
+        const __m256i invalid = _mm256_set1_epi32(Invalid);
+        const int *table = reinterpret_cast<const int *>(PADDED_OUTCOMES.winner);
+
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(boards + i));
+            const __m256i occupied = _mm256_and_si256(packed, low);
+            const __m256i xs = _mm256_and_si256(_mm256_srli_epi32(packed, 16), full);
+
+            // Look up the winner of all eight boards as if they were full, then
+            // replace it with Invalid where they are not.
+            __m256i winner = _mm256_and_si256(_mm256_i32gather_epi32(table, xs, 1), byte);
+            winner = _mm256_blendv_epi8(invalid, winner, _mm256_cmpeq_epi32(occupied, full));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), winner);
+        }
+
+        gameStateBatchScalar(boards + i, out + i, n - i);
+    }
+#endif
+
+    typedef void (*BatchFunction)(const PackedBoard *, Piece *, std::size_t);
+
+    BatchFunction chooseBatchFunction()
+    {
+#ifdef PIEZAS_BATCH_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return &gameStateBatchAvx2;
+#endif
+        return &gameStateBatchScalar;
+    }
+
+    // Checked once, the first time a batch is scored.
+    BatchFunction batchFunction()
+    {
+        static const BatchFunction function = chooseBatchFunction();
+        return function;
+    }
+}
+
+/**
+ * Returns the packed form of a board.
+**/
+PackedBoard packBoard(const Piezas &game)
+{
+    PackedBoard board = { game.occupiedMask(), game.xMask() };
+    return board;
+}
+
+/**
+ * Scores n boards, writing to out[i] exactly what Piezas::gameState would
+ * return for boards[i]: Invalid if any cell is Blank, otherwise the winner,
+ * or Blank for a tie. Uses AVX2 when the processor has it, checked once at
+ * run time, and gameStateBatchScalar otherwise.
+**/
+void gameStateBatch(const PackedBoard *boards, Piece *out, std::size_t n)
+{
+    batchFunction()(boards, out, n);
+}
+
+/**
+ * The portable version of gameStateBatch, one board at a time.
+**/
+void gameStateBatchScalar(const PackedBoard *boards, Piece *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        if (boards[i].occupied != Geometry::fullBoard()) {
+            out[i] = Invalid;
+        } else {
+            out[i] = PiezasOutcomes<BOARD_ROWS, BOARD_COLS>::fullBoardWinner(boards[i].xs & Geometry::fullBoard());
+        }
+    }
+}
+
+/**
+ * Returns whether gameStateBatch uses AVX2 on this processor.
+**/
+bool gameStateBatchUsesAvx2()
+{
+#ifdef PIEZAS_BATCH_AVX2
+    return batchFunction() != &gameStateBatchScalar;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,39 @@
+#ifndef _PIEZAS_BATCH_H_
+#define _PIEZAS_BATCH_H_
+#include "Piezas.h"
+#include <cstddef>
+
+/**
+ * A Piezas board packed into its two bitboards, for scoring many boards at
+ * once. Boards pulled from logs can be stored in this form directly.
+**/
+struct PackedBoard
+{
+  	Piezas::Mask occupied;
+  	Piezas::Mask xs;
+};
+
+/**
+ * Returns the packed form of a board.
+**/
+PackedBoard packBoard(const Piezas &game);
+
+/**
+ * Scores n boards, writing to out[i] exactly what Piezas::gameState would
+ * return for boards[i]: Invalid if any cell is Blank, otherwise the winner,
+ * or Blank for a tie. Uses AVX2 when the processor has it, checked once at
+ * run time, and gameStateBatchScalar otherwise.
+**/
+void gameStateBatch(const PackedBoard *boards, Piece *out, std::size_t n);
+
+/**
+ * The portable version of gameStateBatch, one board at a time.
+**/
+void gameStateBatchScalar(const PackedBoard *boards, Piece *out, std::size_t n);
+
+/**
+ * Returns whether gameStateBatch uses AVX2 on this processor.
+**/
+bool gameStateBatchUsesAvx2();
+
+#endif /*_PIEZAS_BATCH_H_*/
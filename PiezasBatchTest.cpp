@@ -0,0 +1,107 @@
+/**
+ * Unit Tests for gameStateBatch
+**/
+
+#include <gtest/gtest.h>
+#include "PiezasBatch.h"
+#include <vector>
+
+namespace
+{
+    // Builds the full board whose X cells are the bits of "xs", by dropping the pieces
+    // column by column and dropping out of bounds to lose a turn where needed.
+    Piezas fullBoard(unsigned int xs)
+    {
+        Piezas game;
+        for (int col = 0; col < BOARD_COLS; ++col) {
+            for (int row = 0; row < BOARD_ROWS; ++row) {
+                const Piece wanted = ((xs >> (row * BOARD_COLS + col)) & 1) ? X : O;
+                if (game.currentTurn() != wanted)
+                    game.dropPiece(-1);
+                game.dropPiece(col);
+            }
+        }
+        return game;
+    }
+}
+
+
+TEST(PiezasBatchTest, every_full_board_matches_gameState)
+{
+    // This test scores all 4096 full boards in one batch and one board at a time, and
+    // compares both with Piezas::gameState.
+    std::vector<Piezas> games;
+    std::vector<PackedBoard> boards;
+    for (unsigned int xs = 0; xs < (1u << (BOARD_ROWS * BOARD_COLS)); ++xs) {
+        games.push_back(fullBoard(xs));
+        boards.push_back(packBoard(games.back()));
+    }
+
+    std::vector<Piece> batch(boards.size()), scalar(boards.size());
+    gameStateBatch(&boards[0], &batch[0], boards.size());
+    gameStateBatchScalar(&boards[0], &scalar[0], boards.size());
+
+    for (std::size_t i = 0; i < boards.size(); ++i) {
+        const Piece expected = games[i].gameState();
+        ASSERT_NE(expected, Invalid);
+        ASSERT_EQ(batch[i], expected);
+        ASSERT_EQ(scalar[i], expected);
+    }
+}
+
+
+TEST(PiezasBatchTest, partial_boards_are_Invalid)
+{
+    // This test packs every position of pseudo-random games, most of them with Blank
+    // cells, and checks a batch whose size is not a multiple of 8 against gameState.
+    std::vector<PackedBoard> boards;
+    std::vector<Piece> expected;
+    unsigned int state = 31;
+
+    for (int round = 0; round < 100; ++round) {
+        Piezas game;
+        boards.push_back(packBoard(game));
+        expected.push_back(game.gameState());
+        while (game.gameState() == Invalid) {
+            state = state * 1103515245 + 12345;
+            game.dropPiece(static_cast<int>((state >> 16) % BOARD_COLS));
+            boards.push_back(packBoard(game));
+            expected.push_back(game.gameState());
+        }
+    }
+    boards.push_back(boards.front());
+    expected.push_back(expected.front());
+    if (boards.size() % 8 == 0) {
+        boards.push_back(boards.front());
+        expected.push_back(expected.front());
+    }
+
+    std::vector<Piece> batch(boards.size());
+    gameStateBatch(&boards[0], &batch[0], boards.size());
+    for (std::size_t i = 0; i < boards.size(); ++i) {
+        ASSERT_EQ(batch[i], expected[i]);
+    }
+}
+
+
+TEST(PiezasBatchTest, batch_matches_scalar_on_any_masks)
+{
+    // This test checks that the batch and scalar versions agree on arbitrary masks,
+    // including ones no game can reach.
+    std::vector<PackedBoard> boards;
+    unsigned int state = 5;
+    for (int i = 0; i < 10003; ++i) {
+        state = state * 1103515245 + 12345;
+        PackedBoard board = { static_cast<Piezas::Mask>(state >> 8), static_cast<Piezas::Mask>(state >> 3) };
+        if (i % 2)
+            board.occupied = Piezas::Geometry::fullBoard();
+        boards.push_back(board);
+    }
+
+    std::vector<Piece> batch(boards.size()), scalar(boards.size());
+    gameStateBatch(&boards[0], &batch[0], boards.size());
+    gameStateBatchScalar(&boards[0], &scalar[0], boards.size());
+    for (std::size_t i = 0; i < boards.size(); ++i) {
+        ASSERT_EQ(batch[i], scalar[i]);
+    }
+}
@@ -0,0 +1,690 @@
+/**
+ * Micro benchmarks for Piezas
+ *
+ * Usage: PiezasBench [results.json]
+ *
+ * Every benchmark runs a fixed number of iterations, so runs on different
+ * builds do the same work, and is repeated to measure its variance. The
+ * results are printed and written as JSON, to PiezasBench.json unless a
+ * path is given.
+**/
+
+#include "Piezas.h"
+#include "DynamicPiezas.h"
+#include "Solver.h"
+#include "SolvedDatabase.h"
+#include "PiezasBatch.h"
+#include "GameArena.h"
+#include "SelfPlay.h"
+#include "Mcts.h"
+#include "GameRecord.h"
+#include "LogReplay.h"
+#include "ConcurrentPiezas.h"
+#include "Perft.h"
+#include "Anytime.h"
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+    // Small deterministic generator so every run plays the same games.
+    std::uint32_t next_random(std::uint32_t &state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Keeps the optimizer from discarding the results of a benchmark loop.
+    volatile int sink = 0;
+
+    // How many times every benchmark is timed, after a warm-up run of a tenth
+    // of its iterations.
+    const int REPETITIONS = 5;
+
+    // The timings of one benchmark, in nanoseconds per iteration.
+    struct Timing
+    {
+        std::string name;
+        long iterations;
+        double mean;
+        double stddev;
+        double min;
+        double max;
+    };
+
+    // A figure which is not a time per iteration, such as games per second.
+    struct Metric
+    {
+        std::string name;
+        double value;
+        std::string unit;
+    };
+
+    std::vector<Timing> timings;
+    std::vector<Metric> metrics;
+
+    template <typename Body>
+    void run(const char *name, long iterations, Body body)
+    {
+        body(iterations / 10);
+
+        double ns[REPETITIONS];
+        for (int r = 0; r < REPETITIONS; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            body(iterations);
+            const auto stop = std::chrono::steady_clock::now();
+            ns[r] = std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+        }
+
+        Timing timing = { name, iterations, 0, 0, ns[0], ns[0] };
+        for (int r = 0; r < REPETITIONS; ++r) {
+            timing.mean += ns[r] / REPETITIONS;
+            timing.min = std::min(timing.min, ns[r]);
+            timing.max = std::max(timing.max, ns[r]);
+        }
+        for (int r = 0; r < REPETITIONS; ++r) {
+            timing.stddev += (ns[r] - timing.mean) * (ns[r] - timing.mean) / (REPETITIONS - 1);
+        }
+        timing.stddev = std::sqrt(timing.stddev);
+        timings.push_back(timing);
+
+        std::printf("%-40s %12ld iterations %10.2f ns/op +-%5.1f%%\n", name, iterations, timing.mean,
+                    timing.mean > 0 ? 100 * timing.stddev / timing.mean : 0.0);
+    }
+
+    void record(const char *name, double value, const char *unit)
+    {
+        const Metric metric = { name, value, unit };
+        metrics.push_back(metric);
+    }
+
+    // Benchmark names are plain text, but quotes and backslashes are escaped anyway.
+    void writeString(std::FILE *out, const std::string &text)
+    {
+        std::fputc('"', out);
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                std::fputc('\\', out);
+            std::fputc(c, out);
+        }
+        std::fputc('"', out);
+    }
+
+    bool writeJson(const char *path)
+    {
+        std::FILE *out = std::fopen(path, "w");
+        if (out == nullptr)
+            return false;
+
+        std::fprintf(out, "{\n  \"repetitions\": %d,\n  \"timings\": [\n", REPETITIONS);
+        for (std::size_t i = 0; i < timings.size(); ++i) {
+            const Timing &t = timings[i];
+            std::fprintf(out, "    {\"name\": ");
+            writeString(out, t.name);
+            std::fprintf(out, ", \"iterations\": %ld, \"mean_ns\": %.4f, \"stddev_ns\": %.4f, "
+                         "\"min_ns\": %.4f, \"max_ns\": %.4f}%s\n", t.iterations, t.mean, t.stddev,
+                         t.min, t.max, (i + 1 < timings.size()) ? "," : "");
+        }
+        std::fprintf(out, "  ],\n  \"metrics\": [\n");
+        for (std::size_t i = 0; i < metrics.size(); ++i) {
+            std::fprintf(out, "    {\"name\": ");
+            writeString(out, metrics[i].name);
+            std::fprintf(out, ", \"value\": %.4f, \"unit\": ", metrics[i].value);
+            writeString(out, metrics[i].unit);
+            std::fprintf(out, "}%s\n", (i + 1 < metrics.size()) ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+        return std::fclose(out) == 0;
+    }
+
+    // Counts the positions of the game tree down to "depth" moves, copying the
+    // position before every move.
+    long copyTree(const Piezas &game, int depth)
+    {
+        long nodes = 1;
+        if (depth == 0 || game.gameState() != Invalid)
+            return nodes;
+        for (int col = 0; col < BOARD_COLS; ++col) {
+            Piezas child = game;
+            child.dropPiece(col);
+            nodes += copyTree(child, depth - 1);
+        }
+        return nodes;
+    }
+
+    // Counts the same positions as copyTree, making and unmaking moves on one position.
+    long makeUnmakeTree(Piezas &game, int depth)
+    {
+        long nodes = 1;
+        if (depth == 0 || game.gameState() != Invalid)
+            return nodes;
+        for (int col = 0; col < BOARD_COLS; ++col) {
+            const Piezas::Move move = game.makeMove(col);
+            nodes += makeUnmakeTree(game, depth - 1);
+            game.unmakeMove(move);
+        }
+        return nodes;
+    }
+
+    // A game wrapped in a mutex, which every reader and the writer lock.
+    struct LockedPiezas
+    {
+        std::mutex mutex;
+        Piezas game;
+    };
+
+    // Reads a whole board, every pieceAt and gameState, "reads" times on each of
+    // "readers" threads while another thread keeps playing random games, and
+    // returns the boards read per second.
+    template <typename Play, typename Read>
+    double spectate(int readers, long reads, Play play, Read read)
+    {
+        std::atomic<bool> done(false);
+        std::thread writer([&] {
+            std::uint32_t state = 99;
+            while (!done.load(std::memory_order_relaxed)) {
+                play(next_random(state) % BOARD_COLS);
+            }
+        });
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int r = 0; r < readers; ++r) {
+            threads.emplace_back([&] {
+                int sum = 0;
+                for (long i = 0; i < reads; ++i) {
+                    sum += read();
+                }
+                sink += sum;
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+
+        done = true;
+        writer.join();
+        return readers * reads / std::chrono::duration<double>(stop - start).count();
+    }
+
+    // Benchmarks every public method of a board of the given size, on the empty
+    // board "prototype", half way through a game and on the full board, and
+    // whole random games.
+    template <typename Game>
+    void runBoard(const char *size, int rows, int cols, const Game &prototype)
+    {
+        char name[64];
+
+        Game boards[3] = { prototype, prototype, prototype };
+        for (int i = 0; i < rows * cols; ++i) {
+            if (i < rows * cols / 2)
+                boards[1].dropPiece(i % cols);
+            boards[2].dropPiece(i % cols);
+        }
+        const char *board_names[3] = { "empty", "mid-game", "full" };
+
+        std::snprintf(name, sizeof(name), "%s construct", size);
+        run(name, 2000000, [&](long n) {
+            for (long i = 0; i < n; ++i) {
+                Game game(prototype);
+                sink += game.dropPiece(0);
+            }
+        });
+
+        for (int b = 0; b < 3; ++b) {
+            const Game &board = boards[b];
+
+            std::snprintf(name, sizeof(name), "%s pieceAt sweep (%s)", size, board_names[b]);
+            run(name, 2000000 / (rows * cols), [&](long n) {
+                for (long i = 0; i < n; ++i) {
+                    for (int row = 0; row < rows; ++row) {
+                        for (int col = 0; col < cols; ++col) {
+                            sink += board.pieceAt(row, col);
+                        }
+                    }
+                }
+            });
+
+            std::snprintf(name, sizeof(name), "%s gameState (%s)", size, board_names[b]);
+            run(name, 2000000, [&](long n) {
+                for (long i = 0; i < n; ++i) {
+                    sink += board.gameState();
+                }
+            });
+
+            // Every drop starts from a copy of the board, except on the full
+            // board, which a drop does not change.
+            std::snprintf(name, sizeof(name), "%s dropPiece (%s)", size, board_names[b]);
+            run(name, 2000000, [&](long n) {
+                Game game(board);
+                for (long i = 0; i < n; ++i) {
+                    if (b < 2)
+                        game = board;
+                    sink += game.dropPiece(cols - 1);
+                }
+            });
+
+            std::snprintf(name, sizeof(name), "%s copy + reset (%s)", size, board_names[b]);
+            run(name, 2000000, [&](long n) {
+                Game game(board);
+                for (long i = 0; i < n; ++i) {
+                    game = board;
+                    game.reset();
+                    sink += game.pieceAt(0, 0);
+                }
+            });
+        }
+
+        std::snprintf(name, sizeof(name), "%s dropPiece + reset", size);
+        run(name, 2000000, [&](long n) {
+            Game game(prototype);
+            for (long i = 0; i < n; ++i) {
+                for (int col = 0; col < cols; ++col) {
+                    sink += game.dropPiece(col);
+                }
+                game.reset();
+            }
+        });
+
+        std::snprintf(name, sizeof(name), "%s random game", size);
+        run(name, 2000000 / (rows * cols), [&](long n) {
+            std::uint32_t state = 0x9E3779B9u;
+            Game game(prototype);
+            for (long i = 0; i < n; ++i) {
+                game.reset();
+                Piece winner = Invalid;
+                while (winner == Invalid) {
+                    game.dropPiece(next_random(state) % cols);
+                    winner = game.gameState();
+                }
+                sink += winner;
+            }
+        });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *json_path = (argc > 1) ? argv[1] : "PiezasBench.json";
+
+    runBoard("3x4", 3, 4, Piezas());
+    runBoard("4x5", 4, 5, BasicPiezas<4, 5>());
+    runBoard("6x7", 6, 7, BasicPiezas<6, 7>());
+
+    runBoard("dynamic 3x4", 3, 4, DynamicPiezas(3, 4));
+    runBoard("dynamic 6x7", 6, 7, DynamicPiezas(6, 7));
+    runBoard("dynamic 5x3", 5, 3, DynamicPiezas(5, 3));
+
+    // Replay a whole game of moves, one dropPiece call at a time and in one
+    // applyMoves call, with and without the results.
+    {
+        const int moves = BOARD_ROWS * BOARD_COLS;
+        int columns[moves];
+        Piece results[moves];
+        for (int i = 0; i < moves; ++i) {
+            columns[i] = (i * 3) % BOARD_COLS;
+        }
+        run("3x4 dropPiece x12 (per move)", 2000000, [&](long n) {
+            Piezas game;
+            for (long i = 0; i < n / moves; ++i) {
+                game.reset();
+                for (int move = 0; move < moves; ++move) {
+                    sink += game.dropPiece(columns[move]);
+                }
+            }
+        });
+        run("3x4 applyMoves x12 (per move)", 2000000, [&](long n) {
+            Piezas game;
+            for (long i = 0; i < n / moves; ++i) {
+                game.reset();
+                game.applyMoves(columns, moves, results);
+                sink += results[i % moves];
+            }
+        });
+        run("3x4 applyMoves x12 no results (per move)", 2000000, [&](long n) {
+            Piezas game;
+            for (long i = 0; i < n / moves; ++i) {
+                game.reset();
+                sink += static_cast<int>(game.applyMoves(columns, moves));
+            }
+        });
+    }
+
+    // Score a million finished boards, one Piezas at a time and in batches.
+    const std::size_t board_count = 1 << 20;
+    std::vector<Piezas> games(board_count);
+    std::vector<PackedBoard> boards(board_count);
+    std::vector<Piece> winners(board_count);
+    std::uint32_t state = 12345;
+    for (std::size_t i = 0; i < board_count; ++i) {
+        while (games[i].gameState() == Invalid) {
+            games[i].dropPiece(next_random(state) % BOARD_COLS);
+        }
+        boards[i] = packBoard(games[i]);
+    }
+    const long batch_rounds = 20;
+    run("gameState per object (per board)", batch_rounds * board_count, [&](long n) {
+        for (long round = 0; round < n / long(board_count); ++round) {
+            for (std::size_t i = 0; i < board_count; ++i) {
+                winners[i] = games[i].gameState();
+            }
+            sink += winners[round];
+        }
+    });
+    run("gameStateBatchScalar (per board)", batch_rounds * board_count, [&](long n) {
+        for (long round = 0; round < n / long(board_count); ++round) {
+            gameStateBatchScalar(&boards[0], &winners[0], board_count);
+            sink += winners[round];
+        }
+    });
+    run(gameStateBatchUsesAvx2() ? "gameStateBatch AVX2 (per board)" : "gameStateBatch (per board)",
+        batch_rounds * board_count, [&](long n) {
+        for (long round = 0; round < n / long(board_count); ++round) {
+            gameStateBatch(&boards[0], &winners[0], board_count);
+            sink += winners[round];
+        }
+    });
+
+    // Play a move in a million live games, each Piezas on the heap as the
+    // server keeps them, and all of them in one GameArena.
+    std::vector<std::unique_ptr<Piezas> > live_games;
+    GameArena arena(board_count);
+    std::vector<int> slots;
+    for (std::size_t i = 0; i < board_count; ++i) {
+        live_games.emplace_back(new Piezas());
+        slots.push_back(arena.create());
+    }
+    run("heap Piezas dropPiece (per game)", batch_rounds * board_count, [&](long n) {
+        for (long round = 0; round < n / long(board_count); ++round) {
+            for (std::size_t i = 0; i < board_count; ++i) {
+                live_games[i]->reset();
+                sink += live_games[i]->dropPiece(round % BOARD_COLS);
+            }
+        }
+    });
+    run("GameArena dropPieces (per game)", batch_rounds * board_count, [&](long n) {
+        for (long round = 0; round < n / long(board_count); ++round) {
+            for (std::size_t i = 0; i < board_count; ++i) {
+                arena.reset(slots[i]);
+            }
+            arena.dropPieces(&slots[0], board_count, round % BOARD_COLS, &winners[0]);
+            sink += winners[round];
+        }
+    });
+    std::printf("%-40s %12.2f bytes/game (Piezas object %zu bytes)\n", "GameArena memory",
+                arena.bytesPerGame(), sizeof(Piezas));
+    record("GameArena memory", arena.bytesPerGame(), "bytes/game");
+
+    // Search the first 9 moves of the game tree, 349525 positions.
+    run("copy search (per node)", 349525 * 4, [](long n) {
+        for (long i = 0; i < n / 349525; ++i) {
+            sink += copyTree(Piezas(), 9);
+        }
+    });
+    run("make/unmake search (per node)", 349525 * 4, [](long n) {
+        Piezas game;
+        for (long i = 0; i < n / 349525; ++i) {
+            sink += makeUnmakeTree(game, 9);
+        }
+    });
+
+    // Solve the empty board from an empty transposition table each time.
+    Solver solver(16);
+    Solver::Result result = solver.solve(Piezas());
+    run("solve empty 3x4", 100, [&](long n) {
+        for (long i = 0; i < n; ++i) {
+            solver.clear();
+            result = solver.solve(Piezas());
+        }
+    });
+    std::printf("%-40s %12llu nodes %10.0f nodes/s %8.3f ms\n", "solve empty 3x4",
+                static_cast<unsigned long long>(result.nodes), result.nodesPerSecond(),
+                result.seconds * 1e3);
+    record("solve empty 3x4", result.nodesPerSecond(), "nodes/s");
+
+    // Build the solved database once, then time mapping it and looking up
+    // the positions of random games in it.
+    char database_path[] = "/tmp/PiezasBenchDbXXXXXX";
+    const int database_fd = mkstemp(database_path);
+    if (database_fd >= 0) {
+        close(database_fd);
+        SolvedDatabase::BuildStats built;
+        SolvedDatabase::write(database_path, &built);
+        std::printf("%-40s %12u positions %8.3f ms\n", "solved database build", built.positions, built.seconds * 1e3);
+        record("solved database build", built.seconds * 1e3, "ms");
+        run("solved database open + close", 1000, [&](long n) {
+            for (long i = 0; i < n; ++i) {
+                SolvedDatabase database;
+                sink += database.open(database_path);
+            }
+        });
+
+        SolvedDatabase database;
+        database.open(database_path);
+        std::vector<Piezas> positions;
+        for (int g = 0; positions.size() < 4096; ++g) {
+            Piezas game;
+            while (game.gameState() == Invalid && positions.size() < 4096) {
+                positions.push_back(game);
+                game.dropPiece(next_random(state) % BOARD_COLS);
+            }
+        }
+        run("solved database lookup", 10000000, [&](long n) {
+            SolvedDatabase::Entry entry;
+            for (long i = 0; i < n; ++i) {
+                database.lookup(positions[i & 4095], entry);
+                sink += entry.bestColumn;
+            }
+        });
+        std::remove(database_path);
+    }
+
+    // Write a million random games as binary records and read them back.
+    std::vector<GameRecord> records(1000);
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        Piezas game;
+        records[i].moveCount = 0;
+        while (game.gameState() == Invalid) {
+            const int column = next_random(state) % BOARD_COLS;
+            game.dropPiece(column);
+            records[i].moves[records[i].moveCount++] = static_cast<unsigned char>(column);
+        }
+        records[i].winner = game.gameState();
+    }
+    std::stringstream record_stream;
+    std::uint64_t record_bytes = 0;
+    run("GameRecordWriter write (per game)", 1000000, [&](long n) {
+        record_stream.str(std::string());
+        record_stream.clear();
+        GameRecordWriter writer(record_stream);
+        for (long i = 0; i < n; ++i) {
+            writer.write(records[i % records.size()]);
+        }
+        writer.flush();
+        record_bytes = writer.bytesWritten();
+    });
+    run("GameRecordReader read (per game)", 1000000, [&](long n) {
+        record_stream.clear();
+        record_stream.seekg(0);
+        GameRecordReader reader(record_stream);
+        GameRecord record;
+        for (long i = 0; i < n && reader.read(record); ++i) {
+            sink += record.moveCount;
+        }
+    });
+    // The text dump keeps one line per finished match: its 12 cells, the turn
+    // and a newline.
+    std::printf("%-40s %12.2f bytes/game (text dump %d bytes/game)\n", "GameRecord size",
+                record_bytes / 1e6, BOARD_ROWS * BOARD_COLS + 2);
+    record("GameRecord size", record_bytes / 1e6, "bytes/game");
+
+    // Replay a million logged games from a file, in both access modes.
+    char log_path[] = "/tmp/PiezasBenchLogXXXXXX";
+    const int log_fd = mkstemp(log_path);
+    if (log_fd >= 0) {
+        std::FILE *log = fdopen(log_fd, "wb");
+        char line[GameRecord::MAX_MOVES + 3];
+        for (int i = 0; i < 1000000; ++i) {
+            std::fwrite(line, 1, formatLogLine(records[i % records.size()], line), log);
+        }
+        std::fclose(log);
+
+        const LogReplayer::Access accesses[] = { LogReplayer::PRELOAD, LogReplayer::ON_DEMAND };
+        const char *access_names[] = { "preload", "on demand" };
+        for (int a = 0; a < 2; ++a) {
+            const LogReplayer::Stats replayed = LogReplayer(0, accesses[a]).replayFile(log_path, LogReplayer::MismatchSink());
+            char name[64];
+            std::snprintf(name, sizeof(name), "log replay %s, %d thread(s)", access_names[a], replayed.threads);
+            std::printf("%-40s %12.1f MB/s %10.0f games/s %8llu mismatches\n", name, replayed.megabytesPerSecond(),
+                        replayed.gamesPerSecond(), static_cast<unsigned long long>(replayed.mismatches));
+            record(name, replayed.megabytesPerSecond(), "MB/s");
+        }
+        std::remove(log_path);
+    }
+
+    // Spectators reading whole boards of one live game, which one thread keeps
+    // playing, through a mutex and from the lock-free snapshots.
+    const int cores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    const int spectators = std::max(2, cores);
+    LockedPiezas locked;
+    const double locked_reads = spectate(spectators, 2000000, [&](int column) {
+        std::lock_guard<std::mutex> lock(locked.mutex);
+        locked.game.dropPiece(column);
+        if (locked.game.gameState() != Invalid)
+            locked.game.reset();
+    }, [&] {
+        std::lock_guard<std::mutex> lock(locked.mutex);
+        int sum = locked.game.gameState();
+        for (int row = 0; row < BOARD_ROWS; ++row) {
+            for (int col = 0; col < BOARD_COLS; ++col) {
+                sum += locked.game.pieceAt(row, col);
+            }
+        }
+        return sum;
+    });
+    ConcurrentPiezas live;
+    const double snapshot_reads = spectate(spectators, 2000000, [&](int column) {
+        live.dropPiece(column);
+        if (live.gameState() != Invalid)
+            live.reset();
+    }, [&] {
+        const ConcurrentPiezas::Snapshot snapshot = live.snapshot();
+        int sum = snapshot.gameState();
+        for (int row = 0; row < BOARD_ROWS; ++row) {
+            for (int col = 0; col < BOARD_COLS; ++col) {
+                sum += snapshot.pieceAt(row, col);
+            }
+        }
+        return sum;
+    });
+    char spectator_name[64];
+    std::snprintf(spectator_name, sizeof(spectator_name), "board reads, mutex, %d reader(s)", spectators);
+    std::printf("%-40s %12.0f reads/s\n", spectator_name, locked_reads);
+    record(spectator_name, locked_reads, "reads/s");
+    std::snprintf(spectator_name, sizeof(spectator_name), "board reads, snapshot, %d reader(s)", spectators);
+    std::printf("%-40s %12.0f reads/s\n", spectator_name, snapshot_reads);
+    record(spectator_name, snapshot_reads, "reads/s");
+
+    // Self-play games per second, doubling the threads up to the number of cores.
+    for (int threads = 1; ; threads = std::min(2 * threads, cores)) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "self-play %d thread(s)", threads);
+        const SelfPlay::Stats stats = SelfPlay(threads).play(1000000, 1);
+        std::printf("%-40s %12lld games %10.0f games/s %8.2f moves/game\n", name,
+                    static_cast<long long>(stats.games), stats.gamesPerSecond(), stats.averageGameLength());
+        record(name, stats.gamesPerSecond(), "games/s");
+        if (threads == cores)
+            break;
+    }
+
+    // Perft from the empty board, as a tree and with duplicates merged.
+    const Perft::Mode perft_modes[] = { Perft::TREE, Perft::MERGE_DUPLICATES };
+    const int perft_depths[] = { 12, 30 };
+    const char *perft_names[] = { "tree", "merged" };
+    for (int m = 0; m < 2; ++m) {
+        const Perft::Result perft = Perft(cores, perft_modes[m]).run(Piezas(), perft_depths[m]);
+        char name[64];
+        std::snprintf(name, sizeof(name), "perft %d %s, %d thread(s)", perft_depths[m], perft_names[m], perft.threads);
+        std::printf("%-40s %12llu nodes %10.0f nodes/s %10.0f nodes/s/thread\n", name,
+                    static_cast<unsigned long long>(perft.nodes), perft.nodesPerSecond(),
+                    perft.nodesPerSecondPerThread());
+        record(name, perft.nodesPerSecondPerThread(), "nodes/s/thread");
+    }
+
+    // MCTS playouts per second from the empty board, in every mode.
+    const MctsPlayer::Mode modes[] = { MctsPlayer::SERIAL, MctsPlayer::ROOT_PARALLEL, MctsPlayer::TREE_PARALLEL };
+    const char *mode_names[] = { "serial", "root parallel", "tree parallel" };
+    for (int m = 0; m < 3; ++m) {
+        MctsPlayer player(1 << 20, modes[m], cores);
+        player.bestMove(Piezas(), MctsPlayer::Budget::ofIterations(10000));
+        const MctsPlayer::Result mcts = player.bestMove(Piezas(), MctsPlayer::Budget::ofIterations(500000));
+        char name[64];
+        std::snprintf(name, sizeof(name), "mcts %s, %d thread(s)", mode_names[m], player.threadCount());
+        std::printf("%-40s %12lld playouts %10.0f playouts/s %8zu nodes\n", name,
+                    static_cast<long long>(mcts.playouts), mcts.playoutsPerSecond(), mcts.nodes);
+        record(name, mcts.playoutsPerSecond(), "playouts/s");
+    }
+
+    // How far past its deadline the anytime search answers. Every search
+    // starts from a cold table, a few random moves into the game, so that
+    // the short deadlines run out part way through a search.
+    const long deadlines_us[] = { 20, 100, 1000 };
+    for (long deadline_us : deadlines_us) {
+        AnytimePlayer player(16);
+        std::uint32_t random = 777;
+        std::vector<double> latencies;
+        std::uint64_t nodes = 0;
+        double searching = 0;
+        int depths = 0;
+        for (int search = 0; search < 500; ++search) {
+            Piezas game;
+            for (int move = static_cast<int>(next_random(random) % 5); move > 0; --move) {
+                game.dropPiece(next_random(random) % BOARD_COLS);
+            }
+            player.clear();
+            const auto start = std::chrono::steady_clock::now();
+            const AnytimePlayer::Result result = player.bestMove(game, std::chrono::microseconds(deadline_us));
+            latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+            nodes += result.nodes;
+            searching += result.seconds;
+            depths += result.depth;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const double p50 = latencies[latencies.size() / 2];
+        const double p99 = latencies[latencies.size() * 99 / 100];
+        const double worst = latencies.back();
+        char name[64];
+        std::snprintf(name, sizeof(name), "anytime deadline %ldus", deadline_us);
+        std::printf("%-40s %8.1f us p50 %8.1f us p99 %8.1f us max %6.1f depth %10.0f nodes/s\n", name, p50, p99,
+                    worst, double(depths) / latencies.size(), searching > 0 ? nodes / searching : 0.0);
+        char metric[80];
+        std::snprintf(metric, sizeof(metric), "%s p99 latency", name);
+        record(metric, p99, "us");
+        std::snprintf(metric, sizeof(metric), "%s max latency", name);
+        record(metric, worst, "us");
+        std::snprintf(metric, sizeof(metric), "%s search speed", name);
+        record(metric, searching > 0 ? nodes / searching : 0.0, "nodes/s");
+    }
+
+    if (!writeJson(json_path)) {
+        std::fprintf(stderr, "PiezasBench: cannot write %s\n", json_path);
+        return 1;
+    }
+    std::printf("results written to %s\n", json_path);
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include "PiezasInstrument.h"
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace PiezasInstrument
+{
+    namespace
+    {
+        const char *const METHOD_NAMES[METHOD_COUNT] = { "dropPiece", "pieceAt", "gameState", "reset" };
+        const char *const RESULT_NAMES[RESULT_COUNT] = { "X", "O", "Blank", "Invalid" };
+
+        // The buffers of the live threads, and the counters of the threads
+        // which have exited. Both are built on first use, so that they
+        // outlive the thread_local registrations which use them.
+        std::mutex &registryMutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        std::vector<ThreadBuffer *> &liveBuffers()
+        {
+            static std::vector<ThreadBuffer *> buffers;
+            return buffers;
+        }
+
+        Snapshot &retired()
+        {
+            static Snapshot counters = Snapshot();
+            return counters;
+        }
+
+        void addBuffer(Snapshot &total, const ThreadBuffer &buffer)
+        {
+            for (int m = 0; m < METHOD_COUNT; ++m) {
+                total.calls[m] += buffer.calls[m].load(std::memory_order_relaxed);
+                for (int r = 0; r < RESULT_COUNT; ++r) {
+                    total.results[m][r] += buffer.results[m][r].load(std::memory_order_relaxed);
+                }
+                total.ticks[m] += buffer.ticks[m].load(std::memory_order_relaxed);
+                for (int b = 0; b < BUCKETS; ++b) {
+                    const std::uint64_t timed = buffer.histogram[m][b].load(std::memory_order_relaxed);
+                    total.histogram[m][b] += timed;
+                    total.timed[m] += timed;
+                }
+            }
+        }
+
+        void clearBuffer(ThreadBuffer &buffer)
+        {
+            for (int m = 0; m < METHOD_COUNT; ++m) {
+                buffer.calls[m].store(0, std::memory_order_relaxed);
+                for (int r = 0; r < RESULT_COUNT; ++r) {
+                    buffer.results[m][r].store(0, std::memory_order_relaxed);
+                }
+                buffer.ticks[m].store(0, std::memory_order_relaxed);
+                for (int b = 0; b < BUCKETS; ++b) {
+                    buffer.histogram[m][b].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * Owns the buffer of a thread, and hands its counters over to the
+         * retired ones when the thread exits.
+        **/
+        struct Registration
+        {
+            ThreadBuffer buffer;
+
+            Registration()
+                : buffer()
+            {
+                std::lock_guard<std::mutex> lock(registryMutex());
+                liveBuffers().push_back(&buffer);
+            }
+
+            ~Registration()
+            {
+                std::lock_guard<std::mutex> lock(registryMutex());
+                addBuffer(retired(), buffer);
+                std::vector<ThreadBuffer *> &buffers = liveBuffers();
+                for (std::size_t i = 0; i < buffers.size(); ++i) {
+                    if (buffers[i] == &buffer) {
+                        buffers[i] = buffers.back();
+                        buffers.pop_back();
+                        break;
+                    }
+                }
+                currentBuffer() = nullptr;
+            }
+        };
+    }
+
+    /**
+     * Sets up the buffer of the calling thread and returns it.
+    **/
+    ThreadBuffer *registerThread()
+    {
+        static thread_local Registration registration;
+        currentBuffer() = &registration.buffer;
+        return &registration.buffer;
+    }
+
+    /**
+     * Returns the counters of every thread which has recorded anything,
+     * added up.
+    **/
+    Snapshot snapshot()
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        Snapshot total = retired();
+        for (const ThreadBuffer *buffer : liveBuffers()) {
+            addBuffer(total, *buffer);
+        }
+        return total;
+    }
+
+    /**
+     * Sets every counter back to zero. Calls which other threads are
+     * recording meanwhile may be lost or kept.
+    **/
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        retired() = Snapshot();
+        for (ThreadBuffer *buffer : liveBuffers()) {
+            clearBuffer(*buffer);
+        }
+    }
+
+    /**
+     * Returns what a tick is: "cycles" when the time stamp counter is
+     * read, or "nanoseconds" where there is none.
+    **/
+    const char *tickUnit()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return "cycles";
+#else
+        return "nanoseconds";
+#endif
+    }
+
+    /**
+     * Returns a snapshot in the Prometheus text format: the counter
+     * piezas_calls_total by method, the counters piezas_drop_piece_total
+     * and piezas_game_state_total by result, and the histogram
+     * piezas_method_ticks of the timed calls by method.
+    **/
+    std::string formatPrometheus(const Snapshot &snapshot)
+    {
+        std::ostringstream out;
+
+        out << "# HELP piezas_calls_total Calls of each method.\n";
+        out << "# TYPE piezas_calls_total counter\n";
+        for (int m = 0; m < METHOD_COUNT; ++m) {
+            out << "piezas_calls_total{method=\"" << METHOD_NAMES[m] << "\"} " << snapshot.calls[m] << "\n";
+        }
+
+        const Method counted[2] = { DROP_PIECE, GAME_STATE };
+        const char *const counter_names[2] = { "piezas_drop_piece_total", "piezas_game_state_total" };
+        for (int c = 0; c < 2; ++c) {
+            out << "# HELP " << counter_names[c] << " Calls of " << METHOD_NAMES[counted[c]]
+                << " by the Piece returned.\n";
+            out << "# TYPE " << counter_names[c] << " counter\n";
+            for (int r = 0; r < RESULT_COUNT; ++r) {
+                out << counter_names[c] << "{result=\"" << RESULT_NAMES[r] << "\"} "
+                    << snapshot.results[counted[c]][r] << "\n";
+            }
+        }
+
+        // Bucket b holds the calls of up to 2^(b+1) - 1 ticks, and Prometheus
+        // buckets count every call up to their bound.
+        out << "# HELP piezas_method_ticks Latency of every " << SAMPLING << "th call, in " << tickUnit() << ".\n";
+        out << "# TYPE piezas_method_ticks histogram\n";
+        for (int m = 0; m < METHOD_COUNT; ++m) {
+            int last = 0;
+            for (int b = 0; b < BUCKETS; ++b) {
+                if (snapshot.histogram[m][b] != 0)
+                    last = b;
+            }
+            std::uint64_t cumulative = 0;
+            for (int b = 0; b <= last && b < BUCKETS - 1; ++b) {
+                cumulative += snapshot.histogram[m][b];
+                out << "piezas_method_ticks_bucket{method=\"" << METHOD_NAMES[m] << "\",le=\""
+                    << ((std::uint64_t(2) << b) - 1) << "\"} " << cumulative << "\n";
+            }
+            out << "piezas_method_ticks_bucket{method=\"" << METHOD_NAMES[m] << "\",le=\"+Inf\"} "
+                << snapshot.timed[m] << "\n";
+            out << "piezas_method_ticks_sum{method=\"" << METHOD_NAMES[m] << "\"} " << snapshot.ticks[m] << "\n";
+            out << "piezas_method_ticks_count{method=\"" << METHOD_NAMES[m] << "\"} " << snapshot.timed[m] << "\n";
+        }
+        return out.str();
+    }
+
+    /**
+     * Writes the current snapshot in the Prometheus text format to the
+     * file at "path", or to stdout if "path" is null or "-". Returns
+     * whether it was written.
+    **/
+    bool exportPrometheus(const char *path)
+    {
+        const std::string text = formatPrometheus(snapshot());
+        const bool to_stdout = (path == nullptr || std::string(path) == "-");
+
+        std::FILE *out = to_stdout ? stdout : std::fopen(path, "w");
+        if (out == nullptr)
+            return false;
+        bool written = std::fwrite(text.data(), 1, text.size(), out) == text.size();
+        if (to_stdout) {
+            written = (std::fflush(out) == 0) && written;
+        } else {
+            written = (std::fclose(out) == 0) && written;
+        }
+        return written;
+    }
+}
@@ -0,0 +1,219 @@
+#ifndef _PIEZAS_INSTRUMENT_H_
+#define _PIEZAS_INSTRUMENT_H_
+#include <atomic>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * Optional instrumentation of the Piezas hot paths. Building with
+ * PIEZAS_INSTRUMENT defined makes dropPiece, pieceAt, gameState and reset
+ * count their calls and time every PIEZAS_INSTRUMENT_SAMPLING-th of them
+ * with the cycle counter, and makes dropPiece and gameState count what
+ * they return. applyMoves counts every move it plays as a dropPiece call
+ * and its result, but is not timed. Without it the macros below expand
+ * to nothing, and Piezas does exactly what it does without this header.
+ *
+ * Every thread records into a buffer of its own, so recording takes no
+ * lock and shares no cache line with other threads. snapshot() adds up
+ * the buffers of all threads, including those which have exited, and
+ * formatPrometheus turns a snapshot into the Prometheus text format.
+**/
+namespace PiezasInstrument
+{
+  	enum Method
+  	{
+  	  	DROP_PIECE,
+  	  	PIECE_AT,
+  	  	GAME_STATE,
+  	  	RESET,
+  	  	METHOD_COUNT
+  	};
+
+  	// What dropPiece or gameState returned: the Piece X, O, Blank (a tie,
+  	// or a full column) or Invalid.
+  	enum Result
+  	{
+  	  	RESULT_X,
+  	  	RESULT_O,
+  	  	RESULT_BLANK,
+  	  	RESULT_INVALID,
+  	  	RESULT_COUNT
+  	};
+
+  	// Reading the cycle counter takes longer than most of the methods it
+  	// would time, so only every SAMPLING-th call of each method is timed.
+#ifndef PIEZAS_INSTRUMENT_SAMPLING
+#define PIEZAS_INSTRUMENT_SAMPLING 16
+#endif
+  	const unsigned int SAMPLING = PIEZAS_INSTRUMENT_SAMPLING;
+
+  	// Latencies go into power of two buckets: bucket b counts the calls
+  	// which took from 2^b to 2^(b+1) - 1 ticks, bucket 0 also those of 0.
+  	const int BUCKETS = 32;
+
+  	/**
+  	 * The counters of one thread. Only that thread writes them, and other
+  	 * threads read them for a snapshot, so they are atomics updated with a
+  	 * relaxed load and store instead of a locked increment.
+  	**/
+  	struct ThreadBuffer
+  	{
+  	  	// The calls of each method since the last one which was timed.
+  	  	unsigned int untimed[METHOD_COUNT];
+  	  	std::atomic<std::uint64_t> calls[METHOD_COUNT];
+  	  	std::atomic<std::uint64_t> results[METHOD_COUNT][RESULT_COUNT];
+  	  	std::atomic<std::uint64_t> ticks[METHOD_COUNT];
+  	  	std::atomic<std::uint64_t> histogram[METHOD_COUNT][BUCKETS];
+  	};
+
+  	/**
+  	 * The counters of all threads added up. "ticks" and "histogram" only
+  	 * cover the "timed" calls.
+  	**/
+  	struct Snapshot
+  	{
+  	  	std::uint64_t calls[METHOD_COUNT];
+  	  	std::uint64_t results[METHOD_COUNT][RESULT_COUNT];
+  	  	std::uint64_t timed[METHOD_COUNT];
+  	  	std::uint64_t ticks[METHOD_COUNT];
+  	  	std::uint64_t histogram[METHOD_COUNT][BUCKETS];
+  	};
+
+  	/**
+  	 * Returns the counters of every thread which has recorded anything,
+  	 * added up.
+  	**/
+  	Snapshot snapshot();
+
+  	/**
+  	 * Sets every counter back to zero. Calls which other threads are
+  	 * recording meanwhile may be lost or kept.
+  	**/
+  	void clear();
+
+  	/**
+  	 * Returns a snapshot in the Prometheus text format: the counter
+  	 * piezas_calls_total by method, the counters piezas_drop_piece_total
+  	 * and piezas_game_state_total by result, and the histogram
+  	 * piezas_method_ticks of the timed calls by method.
+  	**/
+  	std::string formatPrometheus(const Snapshot &snapshot);
+
+  	/**
+  	 * Writes the current snapshot in the Prometheus text format to the
+  	 * file at "path", or to stdout if "path" is null or "-". Returns
+  	 * whether it was written.
+  	**/
+  	bool exportPrometheus(const char *path);
+
+  	/**
+  	 * Returns what a tick is: "cycles" when the time stamp counter is
+  	 * read, or "nanoseconds" where there is none.
+  	**/
+  	const char *tickUnit();
+
+  	/**
+  	 * Sets up the buffer of the calling thread and returns it.
+  	**/
+  	ThreadBuffer *registerThread();
+
+  	inline ThreadBuffer *&currentBuffer()
+  	{
+  	  	static thread_local ThreadBuffer *buffer = nullptr;
+  	  	return buffer;
+  	}
+
+  	inline ThreadBuffer &threadBuffer()
+  	{
+  	  	ThreadBuffer *buffer = currentBuffer();
+  	  	return buffer ? *buffer : *registerThread();
+  	}
+
+  	inline void add(std::atomic<std::uint64_t> &counter, std::uint64_t amount)
+  	{
+  	  	counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+  	}
+
+  	inline std::uint64_t readTicks()
+  	{
+#if defined(__x86_64__) || defined(__i386__)
+  	  	return __rdtsc();
+#else
+  	  	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+  	  	  	std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  	}
+
+  	inline int bucketOf(std::uint64_t ticks)
+  	{
+  	  	const int bucket = 63 - __builtin_clzll(ticks | 1);
+  	  	return (bucket < BUCKETS) ? bucket : BUCKETS - 1;
+  	}
+
+  	inline void countResult(Method method, Result result)
+  	{
+  	  	add(threadBuffer().results[method][result], 1);
+  	}
+
+  	// Counts calls which are not timed, such as the moves of applyMoves.
+  	inline void countCalls(Method method, std::uint64_t calls)
+  	{
+  	  	add(threadBuffer().calls[method], calls);
+  	}
+
+  	/**
+  	 * Counts the scope it is declared in as one call of a method, and
+  	 * times it if it is the SAMPLING-th call since the last timed one.
+  	**/
+  	class ScopedTimer
+  	{
+  	  public:
+  	  	explicit ScopedTimer(Method method)
+  	  	  	: buffer(threadBuffer()), method(method), start(0), timed(false)
+  	  	{
+  	  	  	add(buffer.calls[method], 1);
+  	  	  	if (++buffer.untimed[method] == SAMPLING) {
+  	  	  	  	buffer.untimed[method] = 0;
+  	  	  	  	timed = true;
+  	  	  	  	start = readTicks();
+  	  	  	}
+  	  	}
+
+  	  	~ScopedTimer()
+  	  	{
+  	  	  	if (timed) {
+  	  	  	  	const std::uint64_t ticks = readTicks() - start;
+  	  	  	  	add(buffer.ticks[method], ticks);
+  	  	  	  	add(buffer.histogram[method][bucketOf(ticks)], 1);
+  	  	  	}
+  	  	}
+
+  	  private:
+  	  	ThreadBuffer &buffer;
+  	  	Method method;
+  	  	std::uint64_t start;
+  	  	bool timed;
+  	};
+}
+
+#ifdef PIEZAS_INSTRUMENT
+#define PIEZAS_INSTRUMENT_TIME(method) \
+  	PiezasInstrument::ScopedTimer piezas_instrument_timer(PiezasInstrument::method)
+#define PIEZAS_INSTRUMENT_RESULT(method, piece) \
+  	PiezasInstrument::countResult(PiezasInstrument::method, \
+  	  	(piece) == X ? PiezasInstrument::RESULT_X : (piece) == O ? PiezasInstrument::RESULT_O : \
+  	  	(piece) == Blank ? PiezasInstrument::RESULT_BLANK : PiezasInstrument::RESULT_INVALID)
+#define PIEZAS_INSTRUMENT_CALLS(method, calls) \
+  	PiezasInstrument::countCalls(PiezasInstrument::method, calls)
+#else
+#define PIEZAS_INSTRUMENT_TIME(method)
+#define PIEZAS_INSTRUMENT_RESULT(method, piece)
+#define PIEZAS_INSTRUMENT_CALLS(method, calls)
+#endif
+
+#endif /*_PIEZAS_INSTRUMENT_H_*/
@@ -0,0 +1,142 @@
+/**
+ * Unit Tests for PiezasInstrument, built with PIEZAS_INSTRUMENT defined
+**/
+
+#include <gtest/gtest.h>
+#include "Piezas.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace PiezasInstrument;
+
+namespace
+{
+    std::uint64_t histogramCalls(const Snapshot &snapshot, Method method)
+    {
+        std::uint64_t timed = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            timed += snapshot.histogram[method][b];
+        }
+        return timed;
+    }
+}
+
+
+TEST(PiezasInstrumentTest, counts_dropPiece_and_gameState_results)
+{
+    // This test plays moves of every kind and checks the counters of each result and
+    // the calls of each method.
+    clear();
+    Piezas game;
+    game.dropPiece(0);
+    game.dropPiece(0);
+    game.dropPiece(0);
+    game.dropPiece(0);
+    game.dropPiece(-1);
+    game.dropPiece(4);
+    game.gameState();
+    game.pieceAt(0, 0);
+    game.pieceAt(5, 5);
+    game.reset();
+
+    const Snapshot counts = snapshot();
+    ASSERT_EQ(counts.results[DROP_PIECE][RESULT_X], 2u);
+    ASSERT_EQ(counts.results[DROP_PIECE][RESULT_O], 1u);
+    ASSERT_EQ(counts.results[DROP_PIECE][RESULT_BLANK], 1u);
+    ASSERT_EQ(counts.results[DROP_PIECE][RESULT_INVALID], 2u);
+    ASSERT_EQ(counts.results[GAME_STATE][RESULT_INVALID], 1u);
+    ASSERT_EQ(counts.calls[DROP_PIECE], 6u);
+    ASSERT_EQ(counts.calls[PIECE_AT], 2u);
+    ASSERT_EQ(counts.calls[GAME_STATE], 1u);
+    ASSERT_EQ(counts.calls[RESET], 1u);
+    for (int m = 0; m < METHOD_COUNT; ++m) {
+        ASSERT_EQ(histogramCalls(counts, static_cast<Method>(m)), counts.timed[m]);
+        ASSERT_LE(counts.timed[m], counts.calls[m]);
+    }
+
+    clear();
+    ASSERT_EQ(snapshot().calls[DROP_PIECE], 0u);
+}
+
+
+TEST(PiezasInstrumentTest, applyMoves_counts_like_dropPiece)
+{
+    // This test plays the moves of the previous test with one applyMoves call and
+    // checks that they are counted as the same dropPiece calls and results.
+    clear();
+    Piezas game;
+    const int columns[] = { 0, 0, 0, 0, -1, 4 };
+    ASSERT_EQ(game.applyMoves(columns, 6), 6u);
+
+    const Snapshot counts = snapshot();
+    ASSERT_EQ(counts.results[DROP_PIECE][RESULT_X], 2u);
+    ASSERT_EQ(counts.results[DROP_PIECE][RESULT_O], 1u);
+    ASSERT_EQ(counts.results[DROP_PIECE][RESULT_BLANK], 1u);
+    ASSERT_EQ(counts.results[DROP_PIECE][RESULT_INVALID], 2u);
+    ASSERT_EQ(counts.calls[DROP_PIECE], 6u);
+    ASSERT_EQ(counts.timed[DROP_PIECE], 0u);
+}
+
+
+TEST(PiezasInstrumentTest, threads_add_up)
+{
+    // This test plays full games on several threads which exit before the snapshot,
+    // and checks that none of their calls are lost, and that every SAMPLING-th call
+    // of each thread was timed.
+    clear();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int game_count = 0; game_count < 1000; ++game_count) {
+                Piezas game;
+                for (int i = 0; i < BOARD_ROWS * BOARD_COLS; ++i) {
+                    game.dropPiece(i % BOARD_COLS);
+                }
+                game.gameState();
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    const Snapshot counts = snapshot();
+    ASSERT_EQ(counts.calls[DROP_PIECE], 4u * 1000u * BOARD_ROWS * BOARD_COLS);
+    ASSERT_EQ(counts.results[DROP_PIECE][RESULT_X] + counts.results[DROP_PIECE][RESULT_O], counts.calls[DROP_PIECE]);
+    ASSERT_EQ(counts.calls[GAME_STATE], 4000u);
+    ASSERT_EQ(counts.results[GAME_STATE][RESULT_INVALID], 0u);
+    ASSERT_EQ(counts.timed[DROP_PIECE], 4u * (1000u * BOARD_ROWS * BOARD_COLS / SAMPLING));
+    ASSERT_EQ(counts.timed[GAME_STATE], 4u * (1000u / SAMPLING));
+    ASSERT_EQ(histogramCalls(counts, DROP_PIECE), counts.timed[DROP_PIECE]);
+}
+
+
+TEST(PiezasInstrumentTest, prometheus_export)
+{
+    // This test exports the counters to a file, checks that the file holds the text of
+    // formatPrometheus, and looks for some of its lines.
+    clear();
+    Piezas game;
+    game.dropPiece(7);
+    game.dropPiece(1);
+
+    const std::string path = "PiezasInstrumentTest.prom";
+    ASSERT_TRUE(exportPrometheus(path.c_str()));
+    std::ifstream in(path.c_str());
+    std::stringstream text;
+    text << in.rdbuf();
+    std::remove(path.c_str());
+
+    ASSERT_EQ(text.str(), formatPrometheus(snapshot()));
+    ASSERT_NE(text.str().find("# TYPE piezas_drop_piece_total counter\n"), std::string::npos);
+    ASSERT_NE(text.str().find("piezas_drop_piece_total{result=\"Invalid\"} 1\n"), std::string::npos);
+    ASSERT_NE(text.str().find("piezas_drop_piece_total{result=\"O\"} 1\n"), std::string::npos);
+    ASSERT_NE(text.str().find("piezas_calls_total{method=\"dropPiece\"} 2\n"), std::string::npos);
+    ASSERT_NE(text.str().find("# TYPE piezas_method_ticks histogram\n"), std::string::npos);
+    ASSERT_NE(text.str().find("piezas_method_ticks_count{method=\"pieceAt\"} 0\n"), std::string::npos);
+    ASSERT_FALSE(exportPrometheus("/nonexistent/PiezasInstrumentTest.prom"));
+}
@@ -0,0 +1,96 @@
+/**
+ * Plays many games at once against a GameServer and reports its latency
+ * and throughput.
+ *
+ * Usage: PiezasLoad [-g games] [-m moves] [-c connections] [-w window]
+ *                   [-s shards] [-p port | -u path] [-h host]
+ *   -g  games played at the same time (default 10000)
+ *   -m  moves played in every game (default 20)
+ *   -c  connections to every shard (default 4)
+ *   -w  requests every connection keeps in flight (default 256)
+ *   -s  number of shards, one per core by default
+ *   -p  load a running PiezasServer on this first TCP port
+ *   -u  load a running PiezasServer on these Unix-domain sockets
+ *   -h  IPv4 address of the server (default 127.0.0.1)
+ *
+ * Without -p or -u the server runs in this process, over TCP on loopback.
+ * Exits with 1 if a request failed and 2 on errors.
+**/
+
+#include "GameServer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    int usage()
+    {
+        std::fprintf(stderr, "usage: PiezasLoad [-g games] [-m moves] [-c connections] [-w window]\n"
+                             "                  [-s shards] [-p port | -u path] [-h host]\n");
+        return 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    LoadConfig load = { std::vector<std::string>(), 10000, 4, 20, 256, 1 };
+    GameServer::Config config = { 0, "", "127.0.0.1", 0 };
+    bool external = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            load.games = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            load.movesPerGame = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            load.connectionsPerShard = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            load.window = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            config.shards = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            config.port = std::atoi(argv[++i]);
+            external = true;
+        } else if (std::strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            config.unixPath = argv[++i];
+            external = true;
+        } else if (std::strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+            config.host = argv[++i];
+        } else {
+            return usage();
+        }
+    }
+
+    GameServer server(config);
+    if (external) {
+        const int shards = config.shards > 0 ? config.shards
+                                             : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        for (int shard = 0; shard < shards; ++shard) {
+            load.addresses.push_back(GameServer::address(config, shard, config.port + shard));
+        }
+    } else {
+        if (!server.start()) {
+            std::fprintf(stderr, "PiezasLoad: %s\n", server.error().c_str());
+            return 2;
+        }
+        for (int shard = 0; shard < server.shardCount(); ++shard) {
+            load.addresses.push_back(server.address(shard));
+        }
+    }
+
+    const LoadStats stats = runLoad(load);
+    std::printf("%d games on %d shard(s), %llu moves, %llu requests, %llu games finished in %.2f s\n",
+                load.games, static_cast<int>(load.addresses.size()), static_cast<unsigned long long>(stats.moves),
+                static_cast<unsigned long long>(stats.requests), static_cast<unsigned long long>(stats.gamesFinished),
+                stats.seconds);
+    std::printf("%.0f moves/s, latency p50 %.1f us, p99 %.1f us, max %.1f us\n", stats.movesPerSecond(),
+                stats.p50Micros, stats.p99Micros, stats.maxMicros);
+    if (!stats.ok) {
+        std::fprintf(stderr, "PiezasLoad: a connection or request failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * Counts the game tree from the empty board, ply by ply.
+ *
+ * Usage: PiezasPerft [-t threads] [-m] depth
+ *   -t  number of threads, one per core by default
+ *   -m  merge duplicate positions at every ply
+ *
+ * Prints, for every ply, the nodes, the finished games by outcome and the
+ * drops into full columns, then the speed.
+**/
+
+#include "Perft.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    int usage()
+    {
+        std::fprintf(stderr, "usage: PiezasPerft [-t threads] [-m] depth\n");
+        return 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int threads = 0;
+    Perft::Mode mode = Perft::TREE;
+    int depth = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-m") == 0) {
+            mode = Perft::MERGE_DUPLICATES;
+        } else if (argv[i][0] != '-' && depth < 0) {
+            depth = std::atoi(argv[i]);
+        } else {
+            return usage();
+        }
+    }
+    if (depth < 0)
+        return usage();
+
+    const Perft::Result result = Perft(threads, mode).run(Piezas(), depth);
+    std::printf("%4s %16s %14s %14s %14s %14s\n", "ply", "nodes", "X wins", "O wins", "ties", "lost turns");
+    for (std::size_t ply = 0; ply < result.plies.size(); ++ply) {
+        const Perft::Ply &counts = result.plies[ply];
+        std::printf("%4d %16llu %14llu %14llu %14llu %14llu\n", static_cast<int>(ply),
+                    static_cast<unsigned long long>(counts.nodes), static_cast<unsigned long long>(counts.xWins),
+                    static_cast<unsigned long long>(counts.oWins), static_cast<unsigned long long>(counts.ties),
+                    static_cast<unsigned long long>(counts.lostTurns));
+    }
+    std::fprintf(stderr, "%llu nodes in %.3f s, %.0f nodes/s, %.0f nodes/s per thread on %d thread(s)\n",
+                 static_cast<unsigned long long>(result.nodes), result.seconds, result.nodesPerSecond(),
+                 result.nodesPerSecondPerThread(), result.threads);
+    return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * Replays a move log and reports every game whose recorded outcome does
+ * not match Piezas.
+ *
+ * Usage: PiezasReplay [-t threads] [-d] [-r begin end] log
+ *   -t  number of threads, one per core by default
+ *   -d  map pages on demand instead of preloading the log
+ *   -r  only replay the lines starting in the byte range [begin, end)
+ *
+ * Mismatches are printed to stdout as "offset: reason", the throughput to
+ * stderr. Exits with 1 if there were mismatches and 2 on errors.
+**/
+
+#include "LogReplay.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    int usage()
+    {
+        std::fprintf(stderr, "usage: PiezasReplay [-t threads] [-d] [-r begin end] log\n");
+        return 2;
+    }
+
+    char outcomeName(Piece outcome)
+    {
+        return (outcome == Blank) ? 'T' : (outcome == Invalid) ? '?' : static_cast<char>(outcome);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int threads = 0;
+    LogReplayer::Access access = LogReplayer::PRELOAD;
+    std::uint64_t begin = 0;
+    std::uint64_t end = ~std::uint64_t(0);
+    const char *path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-d") == 0) {
+            access = LogReplayer::ON_DEMAND;
+        } else if (std::strcmp(argv[i], "-r") == 0 && i + 2 < argc) {
+            begin = std::strtoull(argv[++i], nullptr, 10);
+            end = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argv[i][0] != '-' && path == nullptr) {
+            path = argv[i];
+        } else {
+            return usage();
+        }
+    }
+    if (path == nullptr)
+        return usage();
+
+    const LogReplayer::Stats stats = LogReplayer(threads, access).replayFile(path,
+        [](const ReplayMismatch &mismatch) {
+            if (mismatch.malformed) {
+                std::printf("%llu: malformed\n", static_cast<unsigned long long>(mismatch.offset));
+            } else {
+                std::printf("%llu: recorded %c, replayed %c\n", static_cast<unsigned long long>(mismatch.offset),
+                            outcomeName(mismatch.recorded), outcomeName(mismatch.replayed));
+            }
+        }, begin, end);
+
+    if (!stats.ok) {
+        std::fprintf(stderr, "PiezasReplay: cannot map %s\n", path);
+        return 2;
+    }
+    std::fprintf(stderr, "%llu games, %llu mismatches, %.1f MB/s, %.0f games/s on %d thread(s)\n",
+                 static_cast<unsigned long long>(stats.games), static_cast<unsigned long long>(stats.mismatches),
+                 stats.megabytesPerSecond(), stats.gamesPerSecond(), stats.threads);
+    return stats.mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+/**
+ * Serves Piezas games until interrupted.
+ *
+ * Usage: PiezasServer [-s shards] [-p port | -u path] [-h host]
+ *   -s  number of shards, one per core by default
+ *   -p  first TCP port; shard i listens on port + i (default 7460)
+ *   -u  listen on Unix-domain sockets path.0, path.1, ... instead
+ *   -h  IPv4 address to listen on (default 127.0.0.1)
+ *
+ * Prints the address of every shard, in shard order, to stdout.
+**/
+
+#include "GameServer.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+
+namespace
+{
+    int usage()
+    {
+        std::fprintf(stderr, "usage: PiezasServer [-s shards] [-p port | -u path] [-h host]\n");
+        return 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    GameServer::Config config = { 0, "", "127.0.0.1", 7460 };
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            config.shards = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            config.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            config.unixPath = argv[++i];
+        } else if (std::strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+            config.host = argv[++i];
+        } else {
+            return usage();
+        }
+    }
+
+    // Block the signals before the loops start so only sigwait sees them.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    GameServer server(config);
+    if (!server.start()) {
+        std::fprintf(stderr, "PiezasServer: %s\n", server.error().c_str());
+        return 2;
+    }
+    for (int shard = 0; shard < server.shardCount(); ++shard) {
+        std::printf("%s\n", server.address(shard).c_str());
+    }
+    std::fflush(stdout);
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    server.stop();
+
+    const GameServer::Stats stats = server.stats();
+    std::fprintf(stderr, "%llu connections, %llu requests\n", static_cast<unsigned long long>(stats.connections),
+                 static_cast<unsigned long long>(stats.requests));
+    return 0;
+}
@@ -0,0 +1,73 @@
+/**
+ * Writes the solved database, or looks up a position in it.
+ *
+ * Usage: PiezasSolve -w database
+ *        PiezasSolve database [moves]
+ *   -w     build the database and write it to the file
+ *   moves  the columns dropped into from the empty board, X first, as
+ *          digits; the empty board if left out
+ *
+ * A lookup prints the outcome with perfect play, the best column and how
+ * long opening the database took.
+**/
+
+#include "SolvedDatabase.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    int usage()
+    {
+        std::fprintf(stderr, "usage: PiezasSolve -w database\n       PiezasSolve database [moves]\n");
+        return 2;
+    }
+
+    const char *outcomeName(Piece outcome)
+    {
+        return (outcome == X) ? "X wins" : (outcome == O) ? "O wins" : "tie";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && std::strcmp(argv[1], "-w") == 0) {
+        SolvedDatabase::BuildStats stats;
+        if (!SolvedDatabase::write(argv[2], &stats)) {
+            std::fprintf(stderr, "PiezasSolve: cannot write %s\n", argv[2]);
+            return 2;
+        }
+        std::fprintf(stderr, "%u positions: %u X wins, %u O wins, %u ties, solved in %.3f s\n", stats.positions,
+                     stats.xWins, stats.oWins, stats.ties, stats.seconds);
+        return 0;
+    }
+    if (argc < 2 || argc > 3 || argv[1][0] == '-')
+        return usage();
+
+    Piezas game;
+    if (argc == 3) {
+        for (const char *move = argv[2]; *move != '\0'; ++move) {
+            if (*move < '0' || *move > '9')
+                return usage();
+            game.dropPiece(*move - '0');
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    SolvedDatabase database;
+    if (!database.open(argv[1])) {
+        std::fprintf(stderr, "PiezasSolve: cannot open %s\n", argv[1]);
+        return 2;
+    }
+    const double open_micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    SolvedDatabase::Entry entry;
+    if (!database.lookup(game, entry)) {
+        std::printf("position not reachable\n");
+        return 1;
+    }
+    std::printf("%s, best column %d\n", outcomeName(entry.outcome), entry.bestColumn);
+    std::fprintf(stderr, "opened %u positions in %.1f us\n", database.positionCount(), open_micros);
+    return 0;
+}
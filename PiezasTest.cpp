@@ -4,6 +4,7 @@
 
 #include <gtest/gtest.h>
 #include "Piezas.h"
+#include <unordered_map>
 
 class PiezasTest : public ::testing::Test
 {
@@ -691,3 +692,419 @@ TEST(PiezasTest, dropPiece_full_collumn_modified_gameState)
     Piece winner = game.gameState();
     ASSERT_EQ(winner, O);
 }
+
+
+TEST(PiezasTest, gameState_table_matches_rescan)
+{
+    // This test plays many pseudo-random games, including drops into full and invalid
+    // columns, and calls Piezas::gameState() after every move. The test build defines
+    // PIEZAS_DEBUG_GAMESTATE, so every call also checks the answer looked up in the
+    // table of full boards against a full rescan of the board.
+    Piezas game;
+    unsigned int state = 12345;
+
+    for (int round = 0; round < 1000; ++round) {
+        game.reset();
+        Piece winner = Invalid;
+        for (int move = 0; move < 100 && winner == Invalid; ++move) {
+            state = state * 1103515245 + 12345;
+            game.dropPiece(static_cast<int>((state >> 16) % (BOARD_COLS + 1)) - 1 + (round % 2));
+            winner = game.gameState();
+        }
+        ASSERT_NE(winner, Invalid);
+    }
+}
+
+
+TEST(PiezasTest, board_4x5_dropPiece_Blank)
+{
+    // This test checks that a 4 row, 5 column board fills a column of 4 pieces and
+    // then returns Blank, and that column 5 is out of bounds.
+    BasicPiezas<4, 5> game;
+
+    for (int row = 0; row < 4; ++row) {
+        game.dropPiece(4);
+    }
+
+    ASSERT_EQ(game.pieceAt(3, 4), O);
+    ASSERT_EQ(game.dropPiece(4), Blank);
+    ASSERT_EQ(game.dropPiece(5), Invalid);
+}
+
+
+TEST(PiezasTest, board_4x5_gameState_win_row)
+{
+    // This test checks that the line rule spans all 5 columns of a 4 row, 5 column board.
+    // X fills column 0 while O drops out of bounds, then both players fill the rest of the
+    // board column by column. X gets lines of 5 along rows 0 and 2, O only lines of 4.
+    BasicPiezas<4, 5> game;
+
+    for (int row = 0; row < 4; ++row) {
+        game.dropPiece(0);   // X
+        game.dropPiece(-1);  // O loses the turn
+    }
+    for (int col = 1; col < 5; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            ASSERT_EQ(game.gameState(), Invalid);
+            game.dropPiece(col);
+        }
+    }
+
+    ASSERT_EQ(game.gameState(), X);
+}
+
+
+TEST(PiezasTest, board_6x7_gameState_tie)
+{
+    // This test checks a 6 row, 7 column board where the pieces alternate in every
+    // column and every row, so both players only have lines of 1.
+    BasicPiezas<6, 7> game;
+
+    for (int row = 0; row < 6; ++row) {
+        for (int col = 0; col < 7; ++col) {
+            game.dropPiece(col);
+        }
+    }
+
+    ASSERT_EQ(game.pieceAt(0, 0), X);
+    ASSERT_EQ(game.pieceAt(1, 0), O);
+    ASSERT_EQ(game.pieceAt(0, 1), O);
+    ASSERT_EQ(game.gameState(), Blank);
+}
+
+
+TEST(PiezasTest, unmakeMove_restores_position)
+{
+    // This test makes pseudo-random moves, including drops into full and invalid columns,
+    // and checks that taking each one back with unmakeMove restores the board, the turn
+    // and the game state exactly, and that the move returned what dropPiece returns.
+    Piezas game;
+    unsigned int state = 99;
+
+    for (int round = 0; round < 200; ++round) {
+        game.reset();
+        while (game.gameState() == Invalid) {
+            state = state * 1103515245 + 12345;
+            const int column = static_cast<int>((state >> 16) % (BOARD_COLS + 2)) - 1;
+
+            const Piezas before = game;
+            Piezas dropped = game;
+            const Piezas::Move move = game.makeMove(column);
+            ASSERT_EQ(move.piece, dropped.dropPiece(column));
+
+            game.unmakeMove(move);
+            ASSERT_EQ(game.occupiedMask(), before.occupiedMask());
+            ASSERT_EQ(game.xMask(), before.xMask());
+            ASSERT_EQ(game.currentTurn(), before.currentTurn());
+            ASSERT_EQ(game.gameState(), before.gameState());
+
+            game.makeMove(column);
+        }
+    }
+}
+
+
+TEST(PiezasTest, applyMoves_matches_dropPiece)
+{
+    // This test plays pseudo-random sequences, including drops into full and invalid
+    // columns, with applyMoves and with one dropPiece call per move, and checks both
+    // give the same results, position, turn and hashes, with or without the results.
+    unsigned int state = 7;
+
+    for (int round = 0; round < 200; ++round) {
+        int columns[2 * BOARD_ROWS * BOARD_COLS];
+        state = state * 1103515245 + 12345;
+        const std::size_t n = (state >> 16) % (2 * BOARD_ROWS * BOARD_COLS + 1);
+        for (std::size_t i = 0; i < n; ++i) {
+            state = state * 1103515245 + 12345;
+            columns[i] = static_cast<int>((state >> 16) % (BOARD_COLS + 2)) - 1;
+        }
+
+        Piezas dropped;
+        Piece expected[2 * BOARD_ROWS * BOARD_COLS];
+        std::size_t played = 0;
+        while (played < n && dropped.filledCount() < BOARD_ROWS * BOARD_COLS) {
+            expected[played] = dropped.dropPiece(columns[played]);
+            ++played;
+        }
+
+        Piezas applied, fast;
+        Piece results[2 * BOARD_ROWS * BOARD_COLS];
+        ASSERT_EQ(applied.applyMoves(columns, n, results), played);
+        ASSERT_EQ(fast.applyMoves(columns, n), played);
+        for (std::size_t i = 0; i < played; ++i) {
+            ASSERT_EQ(results[i], expected[i]);
+        }
+        for (const Piezas *game : { &applied, &fast }) {
+            ASSERT_TRUE(*game == dropped);
+            ASSERT_EQ(game->encode(), dropped.encode());
+            ASSERT_EQ(game->hash(), dropped.hash());
+            ASSERT_EQ(game->canonicalHash(), dropped.canonicalHash());
+            ASSERT_EQ(game->gameState(), dropped.gameState());
+        }
+    }
+}
+
+
+TEST(PiezasTest, applyMoves_stops_when_board_is_full)
+{
+    // This test checks that applyMoves plays nothing past the move which fills the
+    // board, leaving the rest of the results alone, and nothing at all on a full board.
+    int columns[BOARD_ROWS * BOARD_COLS + 3];
+    for (int i = 0; i < BOARD_ROWS * BOARD_COLS + 3; ++i) {
+        columns[i] = i % BOARD_COLS;
+    }
+    Piece results[BOARD_ROWS * BOARD_COLS + 3];
+    for (Piece &result : results) {
+        result = Invalid;
+    }
+
+    Piezas game;
+    ASSERT_EQ(game.applyMoves(columns, BOARD_ROWS * BOARD_COLS + 3, results),
+              static_cast<std::size_t>(BOARD_ROWS * BOARD_COLS));
+    ASSERT_EQ(game.filledCount(), BOARD_ROWS * BOARD_COLS);
+    ASSERT_EQ(results[0], X);
+    ASSERT_EQ(results[BOARD_ROWS * BOARD_COLS - 1], O);
+    ASSERT_EQ(results[BOARD_ROWS * BOARD_COLS], Invalid);
+
+    const Piezas full = game;
+    ASSERT_EQ(game.applyMoves(columns, 3, results), 0u);
+    ASSERT_TRUE(game == full);
+    ASSERT_EQ(game.hash(), full.hash());
+}
+
+
+TEST(PiezasTest, hash_same_position_different_order)
+{
+    // This test checks that two move orders which reach the same position give equal
+    // positions with equal hashes, and that the player to move is part of the hash.
+    Piezas first, second;
+
+    first.dropPiece(0);   // X into [0][0]
+    first.dropPiece(1);   // O into [0][1]
+    first.dropPiece(2);   // X into [0][2]
+    second.dropPiece(2);  // X into [0][2]
+    second.dropPiece(1);  // O into [0][1]
+    second.dropPiece(0);  // X into [0][0]
+
+    ASSERT_TRUE(first == second);
+    ASSERT_EQ(first.hash(), second.hash());
+
+    // Losing a turn only changes the player to move.
+    second.dropPiece(-1);
+    ASSERT_TRUE(first != second);
+    ASSERT_NE(first.hash(), second.hash());
+}
+
+
+TEST(PiezasTest, hash_restored_by_unmakeMove_and_reset)
+{
+    // This test checks that unmakeMove restores the hash, and that reset leaves only the
+    // player to move in it.
+    Piezas game;
+    const std::uint64_t empty = game.hash();
+
+    Piezas::Move first = game.makeMove(3);
+    Piezas::Move second = game.makeMove(3);
+    game.unmakeMove(second);
+    game.unmakeMove(first);
+    ASSERT_EQ(game.hash(), empty);
+
+    game.dropPiece(1);
+    game.dropPiece(2);
+    game.reset();
+    ASSERT_EQ(game.hash(), empty);
+    ASSERT_TRUE(game == Piezas());
+}
+
+
+TEST(PiezasTest, hash_unordered_map_key)
+{
+    // This test checks that positions can be used as keys of an unordered_map directly.
+    std::unordered_map<Piezas, int> seen;
+    Piezas game;
+
+    seen[game] = 0;
+    game.dropPiece(0);
+    seen[game] = 1;
+    game.dropPiece(0);
+    seen[game] = 2;
+
+    Piezas again;
+    again.dropPiece(0);
+    ASSERT_EQ(seen.size(), 3u);
+    ASSERT_EQ(seen[again], 1);
+}
+
+
+TEST(PiezasTest, mirrored_same_gameState)
+{
+    // This test plays pseudo-random games and checks after every move that the mirrored
+    // position has every piece in the mirrored column, the same gameState, and the hash
+    // of the position reached by playing the mirrored moves.
+    Piezas game, mirror;
+    unsigned int state = 2024;
+
+    for (int round = 0; round < 200; ++round) {
+        game.reset();
+        mirror.reset();
+        while (game.gameState() == Invalid) {
+            state = state * 1103515245 + 12345;
+            const int column = static_cast<int>((state >> 16) % BOARD_COLS);
+            game.dropPiece(column);
+            mirror.dropPiece(BOARD_COLS - 1 - column);
+
+            Piezas mirrored = game.mirrored();
+            ASSERT_TRUE(mirrored == mirror);
+            ASSERT_EQ(mirrored.hash(), mirror.hash());
+            ASSERT_EQ(mirrored.gameState(), game.gameState());
+            for (int row = 0; row < BOARD_ROWS; ++row) {
+                for (int col = 0; col < BOARD_COLS; ++col) {
+                    ASSERT_EQ(mirrored.pieceAt(row, col), game.pieceAt(row, BOARD_COLS - 1 - col));
+                }
+            }
+        }
+    }
+}
+
+
+TEST(PiezasTest, canonical_same_for_mirror_images)
+{
+    // This test checks that a position and its mirror image have the same canonical
+    // position and hash, and that the column mapping takes a move to the matching move.
+    Piezas game;
+    game.dropPiece(0);  // X into [0][0]
+    game.dropPiece(0);  // O into [1][0]
+    game.dropPiece(1);  // X into [0][1]
+    Piezas mirror = game.mirrored();
+
+    Piezas::Canonical canonical = game.canonical();
+    Piezas::Canonical mirror_canonical = mirror.canonical();
+    ASSERT_TRUE(canonical.position == mirror_canonical.position);
+    ASSERT_EQ(canonical.hash(), mirror_canonical.hash());
+    ASSERT_EQ(game.canonicalHash(), mirror.canonicalHash());
+    ASSERT_NE(canonical.mirrored, mirror_canonical.mirrored);
+
+    // Dropping into column 2 of the original is the same move on the canonical position
+    // as the mapped column.
+    Piezas moved = game;
+    moved.dropPiece(2);
+    Piezas canonical_moved = canonical.position;
+    canonical_moved.dropPiece(canonical.column(2));
+    ASSERT_EQ(moved.canonicalHash(), canonical_moved.canonicalHash());
+}
+
+
+TEST(PiezasTest, legalMoves_matches_dropPiece)
+{
+    // This test plays pseudo-random games and checks before every move that a column is
+    // in legalMoves exactly when dropPiece places a piece there, that columnHeight is the
+    // row the piece lands on, and that filledCount and isFull follow the board.
+    Piezas game;
+    unsigned int state = 5;
+
+    for (int round = 0; round < 100; ++round) {
+        game.reset();
+        while (game.gameState() == Invalid) {
+            for (int col = 0; col < BOARD_COLS; ++col) {
+                Piezas copy = game;
+                const bool open = ((game.legalMoves() >> col) & 1) != 0;
+                const int height = game.columnHeight(col);
+                ASSERT_EQ(copy.dropPiece(col) != Blank, open);
+                if (open) {
+                    ASSERT_EQ(copy.pieceAt(height, col), game.currentTurn());
+                    ASSERT_EQ(game.pieceAt(height, col), Blank);
+                } else {
+                    ASSERT_EQ(height, BOARD_ROWS);
+                }
+            }
+
+            state = state * 1103515245 + 12345;
+            game.dropPiece(static_cast<int>((state >> 16) % BOARD_COLS));
+            ASSERT_EQ(game.isFull(), game.filledCount() == BOARD_ROWS * BOARD_COLS);
+        }
+        ASSERT_TRUE(game.isFull());
+        ASSERT_EQ(game.legalMoves(), 0);
+    }
+    ASSERT_EQ(game.columnHeight(-1), -1);
+    ASSERT_EQ(game.columnHeight(BOARD_COLS), -1);
+}
+
+
+TEST(PiezasTest, orderedLegalMoves_middle_first)
+{
+    // This test checks that the open columns come middle first, and that full columns
+    // are left out.
+    Piezas game;
+    int columns[BOARD_COLS];
+
+    ASSERT_EQ(game.orderedLegalMoves(columns), 4);
+    ASSERT_EQ(columns[0], 1);
+    ASSERT_EQ(columns[1], 2);
+    ASSERT_EQ(columns[2], 0);
+    ASSERT_EQ(columns[3], 3);
+
+    game.dropPiece(2);
+    game.dropPiece(2);
+    game.dropPiece(2);
+    ASSERT_EQ(game.legalMoves(), 0xB);
+    ASSERT_EQ(game.orderedLegalMoves(columns), 3);
+    ASSERT_EQ(columns[0], 1);
+    ASSERT_EQ(columns[1], 0);
+    ASSERT_EQ(columns[2], 3);
+
+    BasicPiezas<6, 7> big;
+    int big_columns[7];
+    ASSERT_EQ(big.orderedLegalMoves(big_columns), 7);
+    ASSERT_EQ(big_columns[0], 3);
+    ASSERT_EQ(big_columns[1], 4);
+    ASSERT_EQ(big_columns[2], 2);
+    ASSERT_EQ(big_columns[6], 0);
+}
+
+
+TEST(PiezasTest, encode_decode_round_trip)
+{
+    // This test encodes every position of pseudo-random games, and checks that decoding
+    // gives back an equal position with the same hash, pieces, turn and gameState.
+    Piezas game;
+    unsigned int state = 17;
+
+    for (int round = 0; round < 100; ++round) {
+        game.reset();
+        for (;;) {
+            const std::uint32_t code = game.encode();
+            ASSERT_TRUE(Piezas::isValidCode(code));
+            ASSERT_LT(code, 1u << 25);
+
+            Piezas decoded = Piezas::decode(code);
+            ASSERT_TRUE(decoded == game);
+            ASSERT_EQ(decoded.hash(), game.hash());
+            ASSERT_EQ(decoded.canonicalHash(), game.canonicalHash());
+            ASSERT_EQ(decoded.filledCount(), game.filledCount());
+            ASSERT_EQ(decoded.gameState(), game.gameState());
+            for (int row = 0; row < BOARD_ROWS; ++row) {
+                for (int col = 0; col < BOARD_COLS; ++col) {
+                    ASSERT_EQ(decoded.pieceAt(row, col), game.pieceAt(row, col));
+                }
+            }
+
+            if (game.gameState() != Invalid)
+                break;
+            state = state * 1103515245 + 12345;
+            game.dropPiece(static_cast<int>((state >> 16) % BOARD_COLS));
+        }
+    }
+}
+
+
+TEST(PiezasTest, isValidCode_rejects_impossible_positions)
+{
+    // This test checks codes which no game can reach: an X on an empty cell, a piece
+    // with an empty cell below it, and bits above the turn.
+    ASSERT_TRUE(Piezas::isValidCode(0));
+    ASSERT_TRUE(Piezas::isValidCode(0x1 | (0x1 << 12)));
+    ASSERT_FALSE(Piezas::isValidCode(0x1 << 12));
+    ASSERT_FALSE(Piezas::isValidCode(0x10));
+    ASSERT_FALSE(Piezas::isValidCode(1u << 25));
+}
@@ -0,0 +1,79 @@
+/**
+ * Plays a round robin between bots which think for a while before every
+ * move, once with coroutines and once with a thread per match, and
+ * reports the standings and matches per second of both.
+ *
+ * Usage: PiezasTournament [-t threads] [-r rounds] [-k thinking] [-T timeout]
+ *   -t  threads for the coroutines, one per core by default
+ *   -r  rounds to play (default 100; 12 matches a round)
+ *   -k  how long the slow bots think before a move, in microseconds
+ *       (default 1000)
+ *   -T  the time every move is given, in microseconds (default 100000)
+**/
+
+#include "Tournament.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    int usage()
+    {
+        std::fprintf(stderr, "usage: PiezasTournament [-t threads] [-r rounds] [-k thinking] [-T timeout]\n");
+        return 2;
+    }
+
+    void report(const char *runner, const Tournament::Result &result)
+    {
+        std::printf("%s: %lld matches, %lld moves in %.3f s on %d thread(s), %.0f matches/s\n", runner,
+                    static_cast<long long>(result.matches), static_cast<long long>(result.moves), result.seconds,
+                    result.threads, result.matchesPerSecond());
+        for (const Tournament::Standing &standing : result.standings) {
+            std::printf("  %-14s %4d points  %5d played  %5d won  %5d lost  %5d tied  %5d on time\n",
+                        standing.name.c_str(), standing.points(), standing.played, standing.wins, standing.losses,
+                        standing.ties, standing.timeouts);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int threads = 0;
+    int rounds = 100;
+    long thinking = 1000;
+    long timeout = 100000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rounds = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            thinking = std::atol(argv[++i]);
+        } else if (std::strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            timeout = std::atol(argv[++i]);
+        } else {
+            return usage();
+        }
+    }
+
+    const PolicyStrategy random_bot(SelfPlay::RANDOM);
+    const PolicyStrategy careful_bot(SelfPlay::AVOID_FULL);
+    const PolicyStrategy slow_random_bot(SelfPlay::RANDOM, MoveTime(thinking));
+    const PolicyStrategy slow_careful_bot(SelfPlay::AVOID_FULL, MoveTime(thinking));
+    Tournament tournament(threads, MoveTime(timeout));
+    tournament.add("random", random_bot);
+    tournament.add("careful", careful_bot);
+    tournament.add("slow random", slow_random_bot);
+    tournament.add("slow careful", slow_careful_bot);
+
+    const Tournament::Result coroutines = tournament.play(rounds, 1, Tournament::COROUTINES);
+    report("coroutines", coroutines);
+    const Tournament::Result threaded = tournament.play(rounds, 1, Tournament::THREAD_PER_MATCH);
+    report("thread per match", threaded);
+    if (threaded.matchesPerSecond() > 0)
+        std::printf("coroutines play %.1fx the matches per second\n",
+                    coroutines.matchesPerSecond() / threaded.matchesPerSecond());
+    return 0;
+}
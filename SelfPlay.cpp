@@ -0,0 +1,214 @@
+#include "SelfPlay.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Games are handed out and stolen in chunks of this many games.
+    const std::int64_t CHUNK_GAMES = 256;
+
+    /**
+     * The random stream of one game: an xorshift64* generator whose state is
+     * derived from the seed and the number of the game with splitmix64.
+    **/
+    struct Random
+    {
+        std::uint64_t state;
+
+        Random(std::uint64_t seed, std::int64_t game)
+        {
+            std::uint64_t mix = seed;
+            mix = PiezasZobrist<BOARD_ROWS, BOARD_COLS>::splitmix64(mix) ^ std::uint64_t(game);
+            state = PiezasZobrist<BOARD_ROWS, BOARD_COLS>::splitmix64(mix);
+            if (state == 0)
+                state = 0x9E3779B97F4A7C15ull;
+        }
+
+        std::uint64_t next()
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 0x2545F4914F6CDD1Dull;
+        }
+
+        // Returns a number from 0 to n - 1.
+        int below(int n)
+        {
+            return static_cast<int>(((next() >> 32) * std::uint64_t(n)) >> 32);
+        }
+    };
+
+    /**
+     * The chunks a worker has left, [begin, end), packed into one word so that
+     * the worker taking a chunk from the front and a thief taking chunks from
+     * the back agree with a single compare and swap. The padding keeps the
+     * ranges of different workers on different cache lines.
+    **/
+    struct Range
+    {
+        std::atomic<std::uint64_t> chunks;
+        char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    std::uint64_t pack(std::uint32_t begin, std::uint32_t end)
+    {
+        return (std::uint64_t(begin) << 32) | end;
+    }
+
+    std::uint32_t begin(std::uint64_t chunks) { return static_cast<std::uint32_t>(chunks >> 32); }
+    std::uint32_t end(std::uint64_t chunks) { return static_cast<std::uint32_t>(chunks); }
+
+    /**
+     * Takes the first chunk of the worker's own range, if any is left.
+    **/
+    bool takeChunk(Range &range, std::uint32_t &chunk)
+    {
+        std::uint64_t chunks = range.chunks.load();
+        while (begin(chunks) < end(chunks)) {
+            if (range.chunks.compare_exchange_weak(chunks, pack(begin(chunks) + 1, end(chunks)))) {
+                chunk = begin(chunks);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Moves the back half of another worker's chunks into the empty range of
+     * worker "self". Returns false if every other worker has run out.
+    **/
+    bool stealChunks(Range *ranges, int count, int self)
+    {
+        for (int k = 1; k < count; ++k) {
+            Range &victim = ranges[(self + k) % count];
+            std::uint64_t chunks = victim.chunks.load();
+            while (begin(chunks) < end(chunks)) {
+                const std::uint32_t middle = end(chunks) - (end(chunks) - begin(chunks) + 1) / 2;
+                if (victim.chunks.compare_exchange_weak(chunks, pack(begin(chunks), middle))) {
+                    ranges[self].chunks.store(pack(middle, end(chunks)));
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Picks the column for the player to move.
+    **/
+    int pickColumn(const Piezas &game, SelfPlay::Policy policy, Random &random)
+    {
+        if (policy == SelfPlay::RANDOM)
+            return random.below(BOARD_COLS);
+
+        int open_columns[BOARD_COLS];
+        const int open_count = game.orderedLegalMoves(open_columns);
+        return open_columns[random.below(open_count)];
+    }
+
+    /**
+     * Plays game number "index" to the end and counts it in "stats".
+    **/
+    void playGame(std::uint64_t seed, std::int64_t index, SelfPlay::Policy xPolicy, SelfPlay::Policy oPolicy,
+                  SelfPlay::Stats &stats)
+    {
+        Random random(seed, index);
+        Piezas game;
+        Piece winner = Invalid;
+
+        while (winner == Invalid) {
+            const SelfPlay::Policy policy = (game.currentTurn() == X) ? xPolicy : oPolicy;
+            if (game.dropPiece(pickColumn(game, policy, random)) == Blank)
+                ++stats.lostTurns;
+            ++stats.moves;
+            winner = game.gameState();
+        }
+
+        ++stats.games;
+        if (winner == X) {
+            ++stats.xWins;
+        } else if (winner == O) {
+            ++stats.oWins;
+        } else {
+            ++stats.ties;
+        }
+    }
+}
+
+/**
+ * Constructor sets up a run on the given number of threads, or on one
+ * thread per core if "threads" is not positive.
+**/
+SelfPlay::SelfPlay(int threads)
+{
+    if (threads < 1)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    this->threads = (threads < 1) ? 1 : threads;
+}
+
+/**
+ * Plays "games" games, X choosing its moves by "xPolicy" and O by
+ * "oPolicy", and returns what happened in them.
+**/
+SelfPlay::Stats SelfPlay::play(std::int64_t games, std::uint64_t seed, Policy xPolicy, Policy oPolicy) const
+{
+    const auto start = std::chrono::steady_clock::now();
+    const Stats zero = { 0, 0, 0, 0, 0, 0, 0, threads };
+    if (games < 0)
+        games = 0;
+
+    // Deal the chunks out evenly.
+    const std::int64_t chunk_count = (games + CHUNK_GAMES - 1) / CHUNK_GAMES;
+    std::unique_ptr<Range[]> ranges(new Range[threads]);
+    for (int t = 0; t < threads; ++t) {
+        ranges[t].chunks.store(pack(static_cast<std::uint32_t>(chunk_count * t / threads),
+                                    static_cast<std::uint32_t>(chunk_count * (t + 1) / threads)));
+    }
+
+    // Every worker counts into a Stats of its own and stores it once at the end.
+    std::vector<Stats> results(threads, zero);
+    auto work = [&](int self) {
+        Stats stats = zero;
+        std::uint32_t chunk = 0;
+        for (;;) {
+            if (!takeChunk(ranges[self], chunk)) {
+                if (!stealChunks(ranges.get(), threads, self))
+                    break;
+                continue;
+            }
+            const std::int64_t first = chunk * CHUNK_GAMES;
+            const std::int64_t last = (first + CHUNK_GAMES < games) ? first + CHUNK_GAMES : games;
+            for (std::int64_t index = first; index < last; ++index) {
+                playGame(seed, index, xPolicy, oPolicy, stats);
+            }
+        }
+        results[self] = stats;
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; ++t) {
+        workers.emplace_back(work, t);
+    }
+    work(0);
+    for (std::size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+
+    Stats total = zero;
+    for (int t = 0; t < threads; ++t) {
+        total.games += results[t].games;
+        total.xWins += results[t].xWins;
+        total.oWins += results[t].oWins;
+        total.ties += results[t].ties;
+        total.moves += results[t].moves;
+        total.lostTurns += results[t].lostTurns;
+    }
+
+    const auto stop = std::chrono::steady_clock::now();
+    total.seconds = std::chrono::duration<double>(stop - start).count();
+    return total;
+}
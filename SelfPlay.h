@@ -0,0 +1,76 @@
+#ifndef _SELF_PLAY_H_
+#define _SELF_PLAY_H_
+#include "Piezas.h"
+#include <cstdint>
+
+/**
+ * Plays large numbers of Piezas games between two simple policies, on all
+ * cores, to produce game statistics. Every game is played with dropPiece
+ * and gameState on its own Piezas.
+ *
+ * The games are split into chunks which are dealt out evenly to the worker
+ * threads up front. A worker which runs out of chunks steals half of the
+ * chunks another worker has left, so every core stays busy until the end.
+ * Game i draws its moves from its own random stream, derived from the seed
+ * and i, so a run gives the same statistics for the same seed whatever the
+ * number of threads and however the chunks were shared out. Each worker
+ * counts into its own statistics, which are added up once the workers have
+ * finished.
+**/
+class SelfPlay
+{
+  public:
+  	/**
+  	 * How a player picks its column.
+  	**/
+  	enum Policy
+  	{
+  	  	// Any column of the board, so a full column may be picked and the
+  	  	// turn lost.
+  	  	RANDOM,
+  	  	// Any column which is not full yet.
+  	  	AVOID_FULL
+  	};
+
+  	/**
+  	 * What happened in the games of a run.
+  	**/
+  	struct Stats
+  	{
+  	  	std::int64_t games;
+  	  	std::int64_t xWins;
+  	  	std::int64_t oWins;
+  	  	std::int64_t ties;
+  	  	// Calls to dropPiece, and how many of them lost the turn.
+  	  	std::int64_t moves;
+  	  	std::int64_t lostTurns;
+  	  	// How long the run took, and on how many threads.
+  	  	double seconds;
+  	  	int threads;
+
+  	  	double averageGameLength() const { return games > 0 ? double(moves) / games : 0; }
+  	  	double gamesPerSecond() const { return seconds > 0 ? games / seconds : 0; }
+  	};
+
+  	/**
+  	 * Constructor sets up a run on the given number of threads, or on one
+  	 * thread per core if "threads" is not positive.
+  	**/
+  	explicit SelfPlay(int threads = 0);
+
+  	/**
+  	 * Returns the number of threads games are played on.
+  	**/
+  	int threadCount() const { return threads; }
+
+  	/**
+  	 * Plays "games" games, X choosing its moves by "xPolicy" and O by
+  	 * "oPolicy", and returns what happened in them.
+  	**/
+  	Stats play(std::int64_t games, std::uint64_t seed, Policy xPolicy = RANDOM, Policy oPolicy = RANDOM) const;
+
+  private:
+  	int threads;
+};
+
+#endif /*_SELF_PLAY_H_*/
@@ -0,0 +1,68 @@
+/**
+ * Unit Tests for SelfPlay
+**/
+
+#include <gtest/gtest.h>
+#include "SelfPlay.h"
+
+namespace
+{
+    void expectSameStats(const SelfPlay::Stats &a, const SelfPlay::Stats &b)
+    {
+        EXPECT_EQ(a.games, b.games);
+        EXPECT_EQ(a.xWins, b.xWins);
+        EXPECT_EQ(a.oWins, b.oWins);
+        EXPECT_EQ(a.ties, b.ties);
+        EXPECT_EQ(a.moves, b.moves);
+        EXPECT_EQ(a.lostTurns, b.lostTurns);
+    }
+}
+
+
+TEST(SelfPlayTest, totals_add_up)
+{
+    // This test checks that every game is counted once, as a win for one player or a
+    // tie, and that every game has at least one move per cell.
+    const SelfPlay::Stats stats = SelfPlay(3).play(10000, 1);
+
+    ASSERT_EQ(stats.games, 10000);
+    ASSERT_EQ(stats.xWins + stats.oWins + stats.ties, stats.games);
+    ASSERT_EQ(stats.moves - stats.lostTurns, stats.games * BOARD_ROWS * BOARD_COLS);
+    ASSERT_GT(stats.lostTurns, 0);
+    ASSERT_EQ(stats.threads, 3);
+}
+
+
+TEST(SelfPlayTest, same_seed_same_stats_on_any_thread_count)
+{
+    // This test plays the same run on 1, 2 and 7 threads, with a number of games which
+    // does not divide into whole chunks, and expects exactly the same statistics.
+    const SelfPlay::Stats one = SelfPlay(1).play(5001, 42, SelfPlay::RANDOM, SelfPlay::AVOID_FULL);
+    expectSameStats(one, SelfPlay(2).play(5001, 42, SelfPlay::RANDOM, SelfPlay::AVOID_FULL));
+    expectSameStats(one, SelfPlay(7).play(5001, 42, SelfPlay::RANDOM, SelfPlay::AVOID_FULL));
+
+    const SelfPlay::Stats other = SelfPlay(1).play(5001, 43, SelfPlay::RANDOM, SelfPlay::AVOID_FULL);
+    ASSERT_NE(one.moves, other.moves);
+}
+
+
+TEST(SelfPlayTest, AVOID_FULL_never_loses_a_turn)
+{
+    // This test checks that players who avoid full columns fill the board in exactly
+    // one move per cell.
+    const SelfPlay::Stats stats = SelfPlay(2).play(3000, 9, SelfPlay::AVOID_FULL, SelfPlay::AVOID_FULL);
+
+    ASSERT_EQ(stats.lostTurns, 0);
+    ASSERT_EQ(stats.averageGameLength(), BOARD_ROWS * BOARD_COLS);
+}
+
+
+TEST(SelfPlayTest, no_games)
+{
+    // This test checks that a run of no games returns empty statistics.
+    const SelfPlay::Stats stats = SelfPlay(4).play(0, 1);
+
+    ASSERT_EQ(stats.games, 0);
+    ASSERT_EQ(stats.moves, 0);
+    ASSERT_EQ(stats.averageGameLength(), 0);
+}
@@ -0,0 +1,337 @@
+#include "SolvedDatabase.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const unsigned char MAGIC[3] = { 'P', 'Z', 'S' };
+    const unsigned char VERSION = 1;
+
+    // Outcomes as stored in an entry.
+    const unsigned char UNREACHABLE = 0;
+    const unsigned char X_WINS = 1;
+    const unsigned char O_WINS = 2;
+    const unsigned char TIE = 3;
+
+    // Values of a position for the player to move, while solving.
+    const signed char LOSS = -1;
+    const signed char DRAW = 0;
+    const signed char WIN = 1;
+
+    const std::uint32_t NONE = ~std::uint32_t(0);
+
+    void writeWord(std::uint32_t value, unsigned char *out)
+    {
+        for (int i = 0; i < 4; ++i) {
+            out[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+
+    /**
+     * Returns the position column "col" of "parent" leads to, or NONE if an
+     * earlier column leads there too, which only passes can.
+    **/
+    std::uint32_t distinctChild(const std::vector<std::uint32_t> &children, std::uint32_t parent, int col)
+    {
+        const std::uint32_t *moves = &children[std::size_t(parent) * BOARD_COLS];
+        for (int earlier = 0; earlier < col; ++earlier) {
+            if (moves[earlier] == moves[col])
+                return NONE;
+        }
+        return moves[col];
+    }
+
+    std::uint32_t readWord(const unsigned char *in)
+    {
+        return std::uint32_t(in[0]) | (std::uint32_t(in[1]) << 8) | (std::uint32_t(in[2]) << 16)
+             | (std::uint32_t(in[3]) << 24);
+    }
+
+    unsigned char outcomeCode(Piece outcome)
+    {
+        return (outcome == X) ? X_WINS : (outcome == O) ? O_WINS : TIE;
+    }
+}
+
+const std::uint32_t SolvedDatabase::COLUMN_STATES;
+const std::size_t SolvedDatabase::HEADER_BYTES;
+
+/**
+ * Constructor sets up a database which is not open.
+**/
+SolvedDatabase::SolvedDatabase()
+    : entries(nullptr), mapping(nullptr), mappedBytes(0), positions(0)
+{
+}
+
+/**
+ * Destructor unmaps the file.
+**/
+SolvedDatabase::~SolvedDatabase()
+{
+    close();
+}
+
+/**
+ * Maps a database file written by write. Returns false, leaving the
+ * database closed, if the file cannot be mapped or its header does not
+ * match this build.
+**/
+bool SolvedDatabase::open(const std::string &path)
+{
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    const std::size_t bytes = HEADER_BYTES + entryCount();
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) != bytes) {
+        ::close(fd);
+        return false;
+    }
+    void *mapped = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+
+    const unsigned char *header = static_cast<const unsigned char *>(mapped);
+    if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || header[3] != VERSION || header[4] != BOARD_ROWS
+        || header[5] != BOARD_COLS || readWord(header + 8) != entryCount()) {
+        munmap(mapped, bytes);
+        return false;
+    }
+    mapping = mapped;
+    mappedBytes = bytes;
+    entries = header + HEADER_BYTES;
+    positions = readWord(header + 12);
+    return true;
+}
+
+void SolvedDatabase::close()
+{
+    if (mapping != nullptr)
+        munmap(mapping, mappedBytes);
+    mapping = nullptr;
+    entries = nullptr;
+    mappedBytes = 0;
+    positions = 0;
+}
+
+/**
+ * Looks up a position. Returns false if the database is not open or
+ * the position cannot be reached from Piezas().
+**/
+bool SolvedDatabase::lookup(const Piezas &game, Entry &entry) const
+{
+    if (entries == nullptr)
+        return false;
+    const unsigned char stored = entries[index(game)];
+    const unsigned char outcome = stored & 3;
+    if (outcome == UNREACHABLE)
+        return false;
+    entry.outcome = (outcome == X_WINS) ? X : (outcome == O_WINS) ? O : Blank;
+    entry.bestColumn = (stored >> 2) - 1;
+    return true;
+}
+
+/**
+ * Returns the entry number of a position: the state of every column
+ * as a digit in base COLUMN_STATES, and the player to move on top.
+**/
+std::uint32_t SolvedDatabase::index(const Piezas &game)
+{
+    const std::uint32_t code = game.encode();
+    const int cells = Piezas::Geometry::CELLS;
+    std::uint32_t result = (code >> (2 * cells)) & 1;
+    for (int col = BOARD_COLS - 1; col >= 0; --col) {
+        // A column of height h with X's at rows r is (2^h - 1) + sum 2^r,
+        // which numbers the columns from 0 to COLUMN_STATES - 1. The first
+        // part is the occupied cells of the column read as a number, and
+        // the second its X's.
+        std::uint32_t state = 0;
+        for (int row = 0; row < BOARD_ROWS; ++row) {
+            const int cell = row * BOARD_COLS + col;
+            state += (((code >> cell) & 1) + ((code >> (cells + cell)) & 1)) << row;
+        }
+        result = result * COLUMN_STATES + state;
+    }
+    return result;
+}
+
+/**
+ * Returns the number of entries in a database.
+**/
+std::uint32_t SolvedDatabase::entryCount()
+{
+    std::uint32_t count = 2;
+    for (int col = 0; col < BOARD_COLS; ++col) {
+        count *= COLUMN_STATES;
+    }
+    return count;
+}
+
+/**
+ * Enumerates the reachable positions, solves them backward from the
+ * end of the game and returns the database file as bytes.
+**/
+std::vector<unsigned char> SolvedDatabase::build(BuildStats *stats)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const std::uint32_t count = entryCount();
+
+    // Every reachable position by its index, found breadth first, with the
+    // position each column leads to. All full columns lead to the same
+    // position, so only the first one counts as a move of its own.
+    std::vector<std::uint32_t> codes(count, NONE);
+    std::vector<std::uint32_t> children(std::size_t(count) * BOARD_COLS, NONE);
+    std::vector<unsigned char> moveCount(count, 0);
+    std::vector<std::uint32_t> order;
+    {
+        const Piezas empty;
+        const std::uint32_t root = index(empty);
+        codes[root] = empty.encode();
+        order.push_back(root);
+    }
+    for (std::size_t next = 0; next < order.size(); ++next) {
+        const std::uint32_t parent = order[next];
+        const Piezas game = Piezas::decode(codes[parent]);
+        if (game.gameState() != Invalid)
+            continue;
+        bool passed = false;
+        for (int col = 0; col < BOARD_COLS; ++col) {
+            Piezas child = game;
+            const bool pass = child.dropPiece(col) == Blank;
+            const std::uint32_t child_index = index(child);
+            children[std::size_t(parent) * BOARD_COLS + col] = child_index;
+            if (pass && passed)
+                continue;
+            passed = passed || pass;
+            ++moveCount[parent];
+            if (codes[child_index] == NONE) {
+                codes[child_index] = child.encode();
+                order.push_back(child_index);
+            }
+        }
+    }
+
+    // The positions each position is reached from, as one list per position.
+    std::vector<std::uint32_t> parentStart(std::size_t(count) + 1, 0);
+    for (std::uint32_t parent : order) {
+        for (int col = 0; col < BOARD_COLS; ++col) {
+            const std::uint32_t child = distinctChild(children, parent, col);
+            if (child != NONE)
+                ++parentStart[child + 1];
+        }
+    }
+    for (std::uint32_t i = 0; i < count; ++i) {
+        parentStart[i + 1] += parentStart[i];
+    }
+    std::vector<std::uint32_t> parents(parentStart[count]);
+    {
+        std::vector<std::uint32_t> filled(parentStart.begin(), parentStart.end() - 1);
+        for (std::uint32_t parent : order) {
+            for (int col = 0; col < BOARD_COLS; ++col) {
+                const std::uint32_t child = distinctChild(children, parent, col);
+                if (child != NONE)
+                    parents[filled[child]++] = parent;
+            }
+        }
+    }
+
+    // Retrograde analysis: start from the finished games, then a position
+    // with a move to a lost position is won, and a position whose moves
+    // all lead to won positions is lost. Whatever is left is a tie. Going
+    // through the queue in order gives every position its distance to the
+    // end of the game, so the winner can head straight for the win.
+    std::vector<signed char> value(count, DRAW);
+    std::vector<bool> solved(count, false);
+    std::vector<std::uint16_t> distance(count, 0);
+    std::vector<std::uint32_t> queue;
+    for (std::uint32_t position : order) {
+        const Piezas game = Piezas::decode(codes[position]);
+        const Piece winner = game.gameState();
+        if (winner == Invalid)
+            continue;
+        solved[position] = true;
+        if (winner != Blank) {
+            value[position] = (winner == game.currentTurn()) ? WIN : LOSS;
+            queue.push_back(position);
+        }
+    }
+    for (std::size_t next = 0; next < queue.size(); ++next) {
+        const std::uint32_t child = queue[next];
+        for (std::uint32_t i = parentStart[child]; i < parentStart[child + 1]; ++i) {
+            const std::uint32_t parent = parents[i];
+            if (solved[parent])
+                continue;
+            if (value[child] == LOSS) {
+                value[parent] = WIN;
+            } else if (--moveCount[parent] == 0) {
+                value[parent] = LOSS;
+            } else {
+                continue;
+            }
+            solved[parent] = true;
+            distance[parent] = static_cast<std::uint16_t>(distance[child] + 1);
+            queue.push_back(parent);
+        }
+    }
+
+    std::vector<unsigned char> file(HEADER_BYTES + count, 0);
+    std::memcpy(&file[0], MAGIC, sizeof(MAGIC));
+    file[3] = VERSION;
+    file[4] = BOARD_ROWS;
+    file[5] = BOARD_COLS;
+    writeWord(count, &file[8]);
+    writeWord(static_cast<std::uint32_t>(order.size()), &file[12]);
+
+    BuildStats totals = { static_cast<std::uint32_t>(order.size()), 0, 0, 0, 0 };
+    for (std::uint32_t position : order) {
+        const Piezas game = Piezas::decode(codes[position]);
+        const Piece mover = game.currentTurn();
+        const Piece other = (mover == X) ? O : X;
+        const Piece outcome = (value[position] == WIN) ? mover : (value[position] == LOSS) ? other : Blank;
+
+        // The winner's move keeps the loser one step closer to losing, the
+        // loser's move keeps the winner as far from winning as possible, and
+        // a tie moves on to another tie.
+        int best = -1;
+        if (game.gameState() == Invalid) {
+            for (int col = 0; col < BOARD_COLS && best < 0; ++col) {
+                const std::uint32_t child = children[std::size_t(position) * BOARD_COLS + col];
+                const bool fits = (value[position] == DRAW) ? value[child] == DRAW
+                                : (value[child] == -value[position] && distance[child] + 1 == distance[position]);
+                if (fits)
+                    best = col;
+            }
+        }
+
+        file[HEADER_BYTES + position] = static_cast<unsigned char>(outcomeCode(outcome) | ((best + 1) << 2));
+        totals.xWins += (outcome == X);
+        totals.oWins += (outcome == O);
+        totals.ties += (outcome == Blank);
+    }
+
+    totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats != nullptr)
+        *stats = totals;
+    return file;
+}
+
+/**
+ * Builds the database and writes it to a file. Returns whether the
+ * file was written.
+**/
+bool SolvedDatabase::write(const std::string &path, BuildStats *stats)
+{
+    const std::vector<unsigned char> file = build(stats);
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&file[0]), static_cast<std::streamsize>(file.size()));
+    out.close();
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,129 @@
+#ifndef _SOLVED_DATABASE_H_
+#define _SOLVED_DATABASE_H_
+#include "Piezas.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * The perfect-play result of every 3x4 position reachable from Piezas()
+ * through dropPiece, worked out once by retrograde analysis and read back
+ * from a memory-mapped file.
+ *
+ * The moves are the columns of the board. Dropping into a full column
+ * places nothing and loses the turn, as in Solver, so positions can repeat;
+ * a position from which neither player can force a win is a tie.
+ *
+ * The file is a header followed by one byte for every board and turn:
+ *
+ *  header: 'P' 'Z' 'S', format version 1, rows, columns, two zero bytes,
+ *          then the number of entries and the number of reachable
+ *          positions, each 4 bytes little endian (16 bytes)
+ *  entry:  the outcome in the low 2 bits, 0 for a position which cannot
+ *          be reached, 1 for X, 2 for O and 3 for a tie; the best column
+ *          plus one in the next 3 bits, 0 for a game which is over.
+ *
+ * The entry of a position is found with index(), from the pieces of each
+ * column, without a search. Opening the file only maps it, so a process can
+ * start answering right away, and the pages it asks about are read in as
+ * they are needed.
+**/
+class SolvedDatabase
+{
+  public:
+  	/**
+  	 * What the database knows about a position.
+  	**/
+  	struct Entry
+  	{
+  	  	// The winner with perfect play from both sides, or Blank for a tie.
+  	  	Piece outcome;
+  	  	// The column the player to move should drop into, or -1 if the game
+  	  	// is over. A winner takes the quickest win and a loser the slowest
+  	  	// loss.
+  	  	int bestColumn;
+  	};
+
+  	/**
+  	 * What building the database found.
+  	**/
+  	struct BuildStats
+  	{
+  	  	std::uint32_t positions;
+  	  	std::uint32_t xWins;
+  	  	std::uint32_t oWins;
+  	  	std::uint32_t ties;
+  	  	double seconds;
+  	};
+
+  	// The states of one column: its height and the X's in it.
+  	static const std::uint32_t COLUMN_STATES = (1u << (BOARD_ROWS + 1)) - 1;
+  	static const std::size_t HEADER_BYTES = 16;
+
+  	/**
+  	 * Constructor sets up a database which is not open.
+  	**/
+  	SolvedDatabase();
+
+  	/**
+  	 * Destructor unmaps the file.
+  	**/
+  	~SolvedDatabase();
+
+  	/**
+  	 * Maps a database file written by write. Returns false, leaving the
+  	 * database closed, if the file cannot be mapped or its header does not
+  	 * match this build.
+  	**/
+  	bool open(const std::string &path);
+
+  	void close();
+
+  	bool isOpen() const { return entries != nullptr; }
+
+  	/**
+  	 * Returns the number of positions in the database.
+  	**/
+  	std::uint32_t positionCount() const { return positions; }
+
+  	/**
+  	 * Looks up a position. Returns false if the database is not open or
+  	 * the position cannot be reached from Piezas().
+  	**/
+  	bool lookup(const Piezas &game, Entry &entry) const;
+
+  	/**
+  	 * Returns the entry number of a position: the state of every column
+  	 * as a digit in base COLUMN_STATES, and the player to move on top.
+  	**/
+  	static std::uint32_t index(const Piezas &game);
+
+  	/**
+  	 * Returns the number of entries in a database.
+  	**/
+  	static std::uint32_t entryCount();
+
+  	/**
+  	 * Enumerates the reachable positions, solves them backward from the
+  	 * end of the game and returns the database file as bytes.
+  	**/
+  	static std::vector<unsigned char> build(BuildStats *stats = nullptr);
+
+  	/**
+  	 * Builds the database and writes it to a file. Returns whether the
+  	 * file was written.
+  	**/
+  	static bool write(const std::string &path, BuildStats *stats = nullptr);
+
+  private:
+  	const unsigned char *entries;
+  	void *mapping;
+  	std::size_t mappedBytes;
+  	std::uint32_t positions;
+
+  	SolvedDatabase(const SolvedDatabase &);
+  	SolvedDatabase &operator=(const SolvedDatabase &);
+};
+
+#endif /*_SOLVED_DATABASE_H_*/
@@ -0,0 +1,174 @@
+/**
+ * Unit Tests for SolvedDatabase
+**/
+
+#include <gtest/gtest.h>
+#include "SolvedDatabase.h"
+#include "Solver.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+
+namespace
+{
+    /**
+     * A temporary file, removed again at the end of the test, which the
+     * database is written to unless "empty" is set.
+    **/
+    struct TempDatabase
+    {
+        std::string path;
+        SolvedDatabase::BuildStats stats;
+
+        explicit TempDatabase(bool empty = false)
+        {
+            char name[] = "/tmp/SolvedDatabaseTest.XXXXXX";
+            const int fd = mkstemp(name);
+            if (fd >= 0)
+                ::close(fd);
+            path = name;
+            if (!empty)
+                SolvedDatabase::write(path, &stats);
+        }
+
+        ~TempDatabase() { std::remove(path.c_str()); }
+    };
+}
+
+
+TEST(SolvedDatabaseTest, index_numbers_every_board)
+{
+    // This test checks that the index of the empty board and of the full boards sits
+    // in range, and that different positions get different entries.
+    Piezas game;
+    ASSERT_EQ(SolvedDatabase::index(game), 0u);
+    ASSERT_EQ(SolvedDatabase::entryCount(), 2 * 15u * 15u * 15u * 15u);
+
+    std::vector<bool> seen(SolvedDatabase::entryCount(), false);
+    seen[0] = true;
+    for (int i = 0; i < BOARD_ROWS * BOARD_COLS; ++i) {
+        game.dropPiece((i * 3) % BOARD_COLS);
+        const std::uint32_t index = SolvedDatabase::index(game);
+        ASSERT_LT(index, SolvedDatabase::entryCount());
+        ASSERT_FALSE(seen[index]);
+        seen[index] = true;
+    }
+}
+
+
+TEST(SolvedDatabaseTest, agrees_with_Solver)
+{
+    // This test looks up positions along many games and checks every outcome against
+    // Solver, and that the best column keeps the outcome.
+    TempDatabase file;
+    SolvedDatabase database;
+    ASSERT_TRUE(database.open(file.path));
+    ASSERT_EQ(database.positionCount(), file.stats.positions);
+    ASSERT_EQ(file.stats.xWins + file.stats.oWins + file.stats.ties, file.stats.positions);
+
+    Solver solver;
+    unsigned int state = 17;
+    int checked = 0;
+    for (int g = 0; g < 40; ++g) {
+        Piezas game;
+        while (true) {
+            SolvedDatabase::Entry entry;
+            ASSERT_TRUE(database.lookup(game, entry));
+            ASSERT_EQ(entry.outcome, solver.solve(game).outcome);
+            ++checked;
+            if (game.gameState() != Invalid) {
+                ASSERT_EQ(entry.bestColumn, -1);
+                ASSERT_EQ(entry.outcome, game.gameState());
+                break;
+            }
+
+            ASSERT_GE(entry.bestColumn, 0);
+            ASSERT_LT(entry.bestColumn, BOARD_COLS);
+            Piezas best = game;
+            best.dropPiece(entry.bestColumn);
+            SolvedDatabase::Entry next;
+            ASSERT_TRUE(database.lookup(best, next));
+            ASSERT_EQ(next.outcome, entry.outcome);
+
+            state = state * 1103515245 + 12345;
+            game.dropPiece(static_cast<int>((state >> 16) % BOARD_COLS));
+        }
+    }
+    ASSERT_GT(checked, 400);
+}
+
+
+TEST(SolvedDatabaseTest, perfect_play_ends_as_promised)
+{
+    // This test plays the best columns for both sides from positions along random games
+    // and checks that a won position ends in a win for the same player, and that
+    // a tied one never leaves a tie.
+    TempDatabase file;
+    SolvedDatabase database;
+    ASSERT_TRUE(database.open(file.path));
+
+    unsigned int state = 3;
+    int wins = 0;
+    for (int g = 0; g < 20; ++g) {
+        Piezas game;
+        while (game.gameState() == Invalid) {
+            SolvedDatabase::Entry promised;
+            ASSERT_TRUE(database.lookup(game, promised));
+            Piezas perfect = game;
+            for (int move = 0; move < 4 * BOARD_ROWS * BOARD_COLS && perfect.gameState() == Invalid; ++move) {
+                SolvedDatabase::Entry entry;
+                ASSERT_TRUE(database.lookup(perfect, entry));
+                ASSERT_EQ(entry.outcome, promised.outcome);
+                perfect.dropPiece(entry.bestColumn);
+            }
+            if (promised.outcome != Blank) {
+                ASSERT_EQ(perfect.gameState(), promised.outcome);
+                ++wins;
+            } else {
+                ASSERT_NE(perfect.gameState(), X);
+                ASSERT_NE(perfect.gameState(), O);
+            }
+
+            state = state * 1103515245 + 12345;
+            game.dropPiece(static_cast<int>((state >> 16) % BOARD_COLS));
+        }
+    }
+    ASSERT_GT(wins, 0);
+}
+
+
+TEST(SolvedDatabaseTest, rejects_bad_files)
+{
+    // This test checks that a missing file, a short file and a file of another version
+    // are not opened, and that lookups on a closed database fail.
+    SolvedDatabase database;
+    ASSERT_FALSE(database.open("/nonexistent/piezas.db"));
+    ASSERT_FALSE(database.isOpen());
+    SolvedDatabase::Entry entry;
+    ASSERT_FALSE(database.lookup(Piezas(), entry));
+
+    TempDatabase file(true);
+    std::vector<unsigned char> bytes = SolvedDatabase::build();
+    bytes[3] = 2;
+    {
+        std::ofstream out(file.path.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&bytes[0]), static_cast<std::streamsize>(bytes.size()));
+    }
+    ASSERT_FALSE(database.open(file.path));
+    {
+        std::ofstream out(file.path.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&bytes[0]), 100);
+    }
+    ASSERT_FALSE(database.open(file.path));
+
+    bytes[3] = 1;
+    {
+        std::ofstream out(file.path.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&bytes[0]), static_cast<std::streamsize>(bytes.size()));
+    }
+    ASSERT_TRUE(database.open(file.path));
+    ASSERT_TRUE(database.lookup(Piezas(), entry));
+    database.close();
+    ASSERT_FALSE(database.lookup(Piezas(), entry));
+}
@@ -0,0 +1,166 @@
+#include "Solver.h"
+#include <chrono>
+
+namespace
+{
+    // Scores of a position for the player to move.
+    const int WIN = 1;
+    const int TIE = 0;
+    const int LOSS = -1;
+}
+
+/**
+ * Constructor sets up a transposition table with 2^tableBits entries.
+**/
+Solver::Solver(int tableBits)
+{
+    if (tableBits < 1)
+        tableBits = 1;
+    if (tableBits > 30)
+        tableBits = 30;
+
+    table.resize(std::size_t(1) << tableBits);
+    tableShift = 64 - tableBits;
+    nodes = 0;
+    clear();
+}
+
+/**
+ * Forgets every position in the transposition table.
+**/
+void Solver::clear()
+{
+    const Entry empty = { 0, 0, EMPTY, -1 };
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        table[i] = empty;
+    }
+}
+
+/**
+ * Solves the given position, as if the previous move was not a pass.
+ * The transposition table is kept between calls, so solving positions
+ * of the same game one after another gets cheaper.
+**/
+Solver::Result Solver::solve(const Piezas &game)
+{
+    nodes = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    // The search plays its moves on this one copy and takes them back again.
+    Piezas position = game;
+    Result result;
+    const int score = negamax(position, false, LOSS, WIN, result.bestColumn);
+
+    const auto stop = std::chrono::steady_clock::now();
+    result.seconds = std::chrono::duration<double>(stop - start).count();
+    result.nodes = nodes;
+
+    const Piece mover = game.currentTurn();
+    const Piece other = (mover == X) ? O : X;
+    if (score == WIN) {
+        result.outcome = mover;
+    } else if (score == LOSS) {
+        result.outcome = other;
+    } else {
+        result.outcome = Blank;
+    }
+
+    return result;
+}
+
+/**
+ * Returns the score of the position for the player to move: 1 for a
+ * win, 0 for a tie and -1 for a loss. "passed" tells whether the
+ * previous move was a pass.
+**/
+int Solver::negamax(Piezas &game, bool passed, int alpha, int beta, int &bestColumn)
+{
+    ++nodes;
+    bestColumn = -1;
+
+    // A full board ends the game.
+    const Piece winner = game.gameState();
+    if (winner != Invalid) {
+        if (winner == Blank)
+            return TIE;
+        return (winner == game.currentTurn()) ? WIN : LOSS;
+    }
+
+    // A position and its mirror image have the same value, so the table only
+    // stores canonical positions, with their best column in canonical terms.
+    // A stored value either answers the question outright, or at least tells
+    // which column to try first.
+    const Piezas::Canonical canonical = game.canonical();
+    const std::uint32_t position_key = key(canonical.position, passed);
+    Entry &entry = table[(position_key * 0x9E3779B97F4A7C15ull) >> tableShift];
+    int stored_column = -1;
+    if (entry.bound != EMPTY && entry.key == position_key) {
+        stored_column = (entry.bestColumn < 0) ? -1 : canonical.column(entry.bestColumn);
+        const bool usable = entry.bound == EXACT
+                         || (entry.bound == LOWER && entry.value >= beta)
+                         || (entry.bound == UPPER && entry.value <= alpha);
+        if (usable) {
+            bestColumn = stored_column;
+            return entry.value;
+        }
+    }
+
+    const int original_alpha = alpha;
+    int best = LOSS - 1;
+    bool tried_pass = false;
+
+    for (int i = -1; i < BOARD_COLS && alpha < beta; ++i) {
+        const int column = (i < 0) ? stored_column : Piezas::Geometry::orderedColumn(i);
+        if (column < 0 || (i >= 0 && column == stored_column))
+            continue;
+
+        const Piezas::Move move = game.makeMove(column);
+        int value = TIE;
+        int reply = -1;
+
+        if (move.piece == Blank) {
+            // Every full column is the same pass, so only try one of them. A
+            // pass answering a pass repeats the position, which is a tie.
+            if (tried_pass) {
+                game.unmakeMove(move);
+                continue;
+            }
+            tried_pass = true;
+            value = passed ? TIE : -negamax(game, true, -beta, -alpha, reply);
+        } else {
+            value = -negamax(game, false, -beta, -alpha, reply);
+        }
+        game.unmakeMove(move);
+
+        if (value > best) {
+            best = value;
+            bestColumn = column;
+        }
+        if (best > alpha)
+            alpha = best;
+    }
+
+    entry.key = position_key;
+    entry.value = static_cast<signed char>(best);
+    entry.bestColumn = static_cast<signed char>((bestColumn < 0) ? -1 : canonical.column(bestColumn));
+    if (best <= original_alpha) {
+        entry.bound = UPPER;
+    } else if (best >= beta) {
+        entry.bound = LOWER;
+    } else {
+        entry.bound = EXACT;
+    }
+
+    return best;
+}
+
+/**
+ * Returns a key which is different for every position and pass state.
+**/
+std::uint32_t Solver::key(const Piezas &game, bool passed)
+{
+    // The encoding of a position takes up to the bit for the player to move.
+    const int cells = Piezas::Geometry::CELLS;
+    static_assert(2 * cells + 2 <= 32, "a position and the pass need to fit in a 32-bit key");
+    return game.encode() | (std::uint32_t(passed) << (2 * cells + 1));
+}
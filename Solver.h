@@ -0,0 +1,96 @@
+#ifndef _SOLVER_H_
+#define _SOLVER_H_
+#include "Piezas.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Plays Piezas perfectly. The solver searches the whole game tree from a
+ * position with negamax and alpha-beta pruning, trying the most promising
+ * columns first and remembering searched positions in a fixed-size
+ * transposition table, and reports who wins with perfect play and which
+ * column the player to move should drop into. The table stores canonical
+ * positions (see Piezas::canonical), so a position and its mirror image
+ * share one entry.
+ *
+ * The moves are the columns of the board. Dropping into a full column
+ * places nothing and loses the turn, exactly like Piezas::dropPiece, so a
+ * player may pass whenever some column is full. If both players pass in a
+ * row the position repeats, and the solver scores such a repetition as a
+ * tie. Out of bounds columns are not moves.
+**/
+class Solver
+{
+  public:
+  	/**
+  	 * What the solver found out about a position.
+  	**/
+  	struct Result
+  	{
+  	  	// The winner with perfect play from both sides, or Blank for a tie.
+  	  	Piece outcome;
+  	  	// The column the player to move should drop into, or -1 if the game
+  	  	// is already over.
+  	  	int bestColumn;
+  	  	// The number of positions searched, and how long the search took.
+  	  	std::uint64_t nodes;
+  	  	double seconds;
+
+  	  	double nodesPerSecond() const { return seconds > 0 ? nodes / seconds : 0; }
+  	};
+
+  	/**
+  	 * Constructor sets up a transposition table with 2^tableBits entries.
+  	**/
+  	explicit Solver(int tableBits = 20);
+
+  	/**
+  	 * Solves the given position, as if the previous move was not a pass.
+  	 * The transposition table is kept between calls, so solving positions
+  	 * of the same game one after another gets cheaper.
+  	**/
+  	Result solve(const Piezas &game);
+
+  	/**
+  	 * Forgets every position in the transposition table.
+  	**/
+  	void clear();
+
+  private:
+  	// Whether a stored value is exact, or only a lower or upper bound
+  	// because the search of that position was cut off.
+  	enum Bound
+  	{
+  	  	EMPTY = 0,
+  	  	EXACT,
+  	  	LOWER,
+  	  	UPPER
+  	};
+
+  	struct Entry
+  	{
+  	  	std::uint32_t key;
+  	  	signed char value;
+  	  	unsigned char bound;
+  	  	signed char bestColumn;
+  	};
+
+  	std::vector<Entry> table;
+  	int tableShift;
+  	std::uint64_t nodes;
+
+  	/**
+  	 * Returns the score of the position for the player to move: 1 for a
+  	 * win, 0 for a tie and -1 for a loss. "passed" tells whether the
+  	 * previous move was a pass. Moves are made on "game" and taken back
+  	 * before returning, so the search never copies a position.
+  	**/
+  	int negamax(Piezas &game, bool passed, int alpha, int beta, int &bestColumn);
+
+  	/**
+  	 * Returns a key which is different for every position and pass state.
+  	**/
+  	static std::uint32_t key(const Piezas &game, bool passed);
+};
+
+#endif /*_SOLVER_H_*/
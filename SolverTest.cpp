@@ -0,0 +1,105 @@
+/**
+ * Unit Tests for Solver
+**/
+
+#include <gtest/gtest.h>
+#include "Solver.h"
+
+namespace
+{
+    // Plain minimax without pruning or a transposition table, following the same
+    // rules as the solver. Returns the score for the player to move.
+    int referenceScore(const Piezas &game, bool passed)
+    {
+        Piezas position = game;
+        const Piece winner = position.gameState();
+        if (winner != Invalid) {
+            if (winner == Blank)
+                return 0;
+            return (winner == game.currentTurn()) ? 1 : -1;
+        }
+
+        int best = -2;
+        bool tried_pass = false;
+        for (int col = 0; col < BOARD_COLS; ++col) {
+            Piezas child = game;
+            int value = 0;
+            if (child.dropPiece(col) == Blank) {
+                if (tried_pass)
+                    continue;
+                tried_pass = true;
+                value = passed ? 0 : -referenceScore(child, true);
+            } else {
+                value = -referenceScore(child, false);
+            }
+            if (value > best)
+                best = value;
+        }
+        return best;
+    }
+
+    // The winner for a score of the player to move.
+    Piece outcomeOf(const Piezas &game, int score)
+    {
+        if (score == 0)
+            return Blank;
+        const Piece other = (game.currentTurn() == X) ? O : X;
+        return (score > 0) ? game.currentTurn() : other;
+    }
+}
+
+
+TEST(SolverTest, empty_board_is_tie)
+{
+    // This test checks the solution of the empty board: with perfect play the game is a tie.
+    Solver solver;
+    Piezas game;
+
+    Solver::Result result = solver.solve(game);
+    ASSERT_EQ(result.outcome, Blank);
+    ASSERT_GE(result.bestColumn, 0);
+    ASSERT_LT(result.bestColumn, BOARD_COLS);
+    ASSERT_GT(result.nodes, 0u);
+}
+
+
+TEST(SolverTest, full_board_is_gameState)
+{
+    // This test checks that a finished game is answered with its gameState and no move.
+    Solver solver;
+    Piezas game;
+
+    for (int i = 0; i < BOARD_ROWS * BOARD_COLS; ++i) {
+        game.dropPiece(i % BOARD_COLS);
+    }
+
+    Solver::Result result = solver.solve(game);
+    ASSERT_EQ(result.outcome, game.gameState());
+    ASSERT_EQ(result.bestColumn, -1);
+}
+
+
+TEST(SolverTest, matches_reference_minimax)
+{
+    // This test solves positions reached by pseudo-random moves, including drops into
+    // full columns which lose the turn, and compares the solver against plain minimax.
+    // The best column has to reach the solved outcome.
+    Solver solver(12);
+    unsigned int state = 7;
+
+    for (int round = 0; round < 60; ++round) {
+        Piezas game;
+        for (int move = 0; move < 6; ++move) {
+            state = state * 1103515245 + 12345;
+            game.dropPiece(static_cast<int>((state >> 16) % BOARD_COLS));
+        }
+
+        const int score = referenceScore(game, false);
+        Solver::Result result = solver.solve(game);
+        ASSERT_EQ(result.outcome, outcomeOf(game, score));
+
+        Piezas child = game;
+        const bool pass = child.dropPiece(result.bestColumn) == Blank;
+        ASSERT_EQ(-referenceScore(child, pass), score);
+    }
+}
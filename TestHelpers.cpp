@@ -0,0 +1,51 @@
+#include "TestHelpers.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Counts every allocation made by the test program.
+    std::atomic<long> allocations(0);
+}
+
+void *operator new(std::size_t size)
+{
+    ++allocations;
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+/**
+ * Returns the number of allocations the test program has made so far.
+**/
+long allocationCount()
+{
+    return allocations.load();
+}
+
+/**
+ * Plays pseudo-random moves from the empty board until "empty" cells are
+ * left, advancing "state" as it goes.
+**/
+Piezas randomPosition(unsigned int &state, int empty)
+{
+    Piezas game;
+    for (int placed = 0; placed < BOARD_ROWS * BOARD_COLS - empty; ) {
+        state = state * 1103515245 + 12345;
+        if (game.dropPiece(static_cast<int>((state >> 16) % BOARD_COLS)) != Blank)
+            ++placed;
+    }
+    return game;
+}
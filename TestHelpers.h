@@ -0,0 +1,22 @@
+#ifndef _TEST_HELPERS_H_
+#define _TEST_HELPERS_H_
+#include "Piezas.h"
+
+/**
+ * Helpers shared by the unit tests of the players. Linking TestHelpers.o
+ * into a test program also replaces its operator new, so that the test can
+ * count the allocations a search makes.
+**/
+
+/**
+ * Returns the number of allocations the test program has made so far.
+**/
+long allocationCount();
+
+/**
+ * Plays pseudo-random moves from the empty board until "empty" cells are
+ * left, advancing "state" as it goes.
+**/
+Piezas randomPosition(unsigned int &state, int empty);
+
+#endif /*_TEST_HELPERS_H_*/
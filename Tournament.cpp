@@ -0,0 +1,573 @@
+#include "Tournament.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * The random stream of one match, as SelfPlay draws the stream of one
+     * game: xorshift64* seeded from the seed and the match number.
+    **/
+    struct Random
+    {
+        std::uint64_t state;
+
+        Random(std::uint64_t seed, std::int64_t match)
+        {
+            std::uint64_t mix = seed;
+            mix = PiezasZobrist<BOARD_ROWS, BOARD_COLS>::splitmix64(mix) ^ std::uint64_t(match);
+            state = PiezasZobrist<BOARD_ROWS, BOARD_COLS>::splitmix64(mix);
+            if (state == 0)
+                state = 0x9E3779B97F4A7C15ull;
+        }
+
+        std::uint64_t next()
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 0x2545F4914F6CDD1Dull;
+        }
+    };
+
+    // Returns a number from 0 to n - 1 taken from "random".
+    int below(std::uint64_t random, int n)
+    {
+        return static_cast<int>(((random >> 32) * std::uint64_t(n)) >> 32);
+    }
+
+    /**
+     * Who plays a match and how it went.
+    **/
+    struct Match
+    {
+        int x;
+        int o;
+        // X, O or Blank for a tie.
+        Piece winner;
+        bool lostOnTime;
+        int moves;
+    };
+
+    /**
+     * An answer as the match sees it.
+    **/
+    struct Answer
+    {
+        int column;
+        bool timedOut;
+    };
+
+    /**
+     * Plays an answer on the game of a match. Returns whether the match is
+     * over.
+    **/
+    bool playAnswer(Piezas &game, Match &match, const Answer &answer)
+    {
+        if (answer.timedOut) {
+            match.winner = (game.currentTurn() == X) ? O : X;
+            match.lostOnTime = true;
+            return true;
+        }
+        game.dropPiece(answer.column);
+        ++match.moves;
+        const Piece state = game.gameState();
+        if (state != Invalid || match.moves >= Tournament::MAX_MOVES) {
+            match.winner = (state == Invalid) ? Blank : state;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Counts down the matches still being played, and wakes up the caller
+     * of play when the last one is over. The count only changes under the
+     * lock, so the caller cannot see it reach zero before the last match
+     * is done with the lock and the condition variable.
+    **/
+    struct Finish
+    {
+        std::int64_t remaining;
+        std::mutex lock;
+        std::condition_variable done;
+
+        explicit Finish(std::int64_t matches) : remaining(matches) {}
+
+        void matchOver()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (--remaining == 0)
+                done.notify_all();
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            done.wait(guard, [this] { return remaining == 0; });
+        }
+    };
+
+    class Scheduler;
+
+    /**
+     * A move a coroutine waits for. The answer and the timeout race to
+     * claim it; the winner resumes the coroutine on the pool, unless it is
+     * still being asked, in which case it does not suspend at all. The
+     * scheduler outlives every move, as a strategy may hold on to one, and
+     * answer it, after its match is over.
+    **/
+    struct CoroutineMove : MoveRequest::Pending, std::enable_shared_from_this<CoroutineMove>
+    {
+        enum Phase
+        {
+            ASKING,
+            SUSPENDED,
+            ANSWERED
+        };
+
+        Scheduler &scheduler;
+        std::coroutine_handle<> handle;
+        std::atomic<bool> claimed;
+        std::atomic<int> phase;
+        Answer result;
+
+        CoroutineMove(Scheduler &scheduler, std::coroutine_handle<> handle);
+        ~CoroutineMove();
+
+        void answer(int column, MoveTime after);
+        void finish(int column, bool timedOut);
+    };
+
+    /**
+     * The pool the match coroutines run on, and the timer thread which
+     * delivers delayed answers and timeouts.
+    **/
+    class Scheduler
+    {
+      public:
+        explicit Scheduler(int threads)
+            : liveMoves(0), stopping(false)
+        {
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([this] { work(); });
+            }
+            timerThread = std::thread([this] { runTimers(); });
+        }
+
+        /**
+         * Stops the threads, then waits until every move has been let go
+         * of, by the timers and by the strategies.
+        **/
+        ~Scheduler()
+        {
+            {
+                std::lock_guard<std::mutex> guard(queueLock);
+                std::lock_guard<std::mutex> timer_guard(timerLock);
+                stopping = true;
+            }
+            ready.notify_all();
+            timerWake.notify_all();
+            for (std::thread &worker : workers) {
+                worker.join();
+            }
+            timerThread.join();
+            while (!timers.empty()) {
+                timers.pop();
+            }
+
+            std::unique_lock<std::mutex> guard(moveLock);
+            movesReleased.wait(guard, [this] { return liveMoves == 0; });
+        }
+
+        // Notifying under the lock keeps "ready" alive until it is done:
+        // the last match may end, and the scheduler go, as soon as the
+        // handle is in the queue.
+        void post(std::coroutine_handle<> handle)
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            queue.push_back(handle);
+            ready.notify_one();
+        }
+
+        void holdMove()
+        {
+            std::lock_guard<std::mutex> guard(moveLock);
+            ++liveMoves;
+        }
+
+        void releaseMove()
+        {
+            std::lock_guard<std::mutex> guard(moveLock);
+            if (--liveMoves == 0)
+                movesReleased.notify_all();
+        }
+
+        /**
+         * Finishes "move" with "column" at "when", unless the scheduler is
+         * stopping by then, which only happens once every match is over.
+        **/
+        void at(Clock::time_point when, const std::shared_ptr<CoroutineMove> &move, int column, bool timedOut)
+        {
+            bool earliest;
+            {
+                std::lock_guard<std::mutex> guard(timerLock);
+                if (stopping)
+                    return;
+                earliest = timers.empty() || when < timers.top().when;
+                const Timer timer = { when, move, column, timedOut };
+                timers.push(timer);
+            }
+            if (earliest)
+                timerWake.notify_one();
+        }
+
+      private:
+        struct Timer
+        {
+            Clock::time_point when;
+            std::shared_ptr<CoroutineMove> move;
+            int column;
+            bool timedOut;
+
+            bool operator>(const Timer &other) const { return when > other.when; }
+        };
+
+        void work()
+        {
+            for (;;) {
+                std::coroutine_handle<> handle;
+                {
+                    std::unique_lock<std::mutex> guard(queueLock);
+                    ready.wait(guard, [this] { return stopping || !queue.empty(); });
+                    if (queue.empty())
+                        return;
+                    handle = queue.front();
+                    queue.pop_front();
+                }
+                handle.resume();
+            }
+        }
+
+        void runTimers()
+        {
+            std::unique_lock<std::mutex> guard(timerLock);
+            while (!stopping) {
+                if (timers.empty()) {
+                    timerWake.wait(guard);
+                } else if (Clock::now() < timers.top().when) {
+                    // A copy, as the heap may grow while this waits.
+                    const Clock::time_point next = timers.top().when;
+                    timerWake.wait_until(guard, next);
+                } else {
+                    const Timer timer = timers.top();
+                    timers.pop();
+                    guard.unlock();
+                    timer.move->finish(timer.column, timer.timedOut);
+                    guard.lock();
+                }
+            }
+        }
+
+        std::mutex queueLock;
+        std::condition_variable ready;
+        std::deque<std::coroutine_handle<> > queue;
+        std::vector<std::thread> workers;
+
+        std::mutex timerLock;
+        std::condition_variable timerWake;
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> > timers;
+        std::thread timerThread;
+
+        // The moves which have not been destroyed yet.
+        std::mutex moveLock;
+        std::condition_variable movesReleased;
+        std::int64_t liveMoves;
+
+        bool stopping;
+    };
+
+    CoroutineMove::CoroutineMove(Scheduler &scheduler, std::coroutine_handle<> handle)
+        : scheduler(scheduler), handle(handle), claimed(false), phase(ASKING)
+    {
+        scheduler.holdMove();
+    }
+
+    CoroutineMove::~CoroutineMove()
+    {
+        scheduler.releaseMove();
+    }
+
+    void CoroutineMove::answer(int column, MoveTime after)
+    {
+        // A move which has timed out needs nothing more from the scheduler.
+        if (claimed.load())
+            return;
+        if (after > MoveTime(0)) {
+            scheduler.at(Clock::now() + after, shared_from_this(), column, false);
+        } else {
+            finish(column, false);
+        }
+    }
+
+    void CoroutineMove::finish(int column, bool timedOut)
+    {
+        if (claimed.exchange(true))
+            return;
+        result.column = column;
+        result.timedOut = timedOut;
+        if (phase.exchange(ANSWERED) == SUSPENDED)
+            scheduler.post(handle);
+    }
+
+    /**
+     * What a match coroutine co_awaits to get a move from a strategy.
+    **/
+    struct MoveAwaiter
+    {
+        Scheduler &scheduler;
+        const Strategy &strategy;
+        const Piezas &position;
+        std::uint64_t random;
+        MoveTime timeout;
+        std::shared_ptr<CoroutineMove> move;
+
+        bool await_ready() const { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            move = std::make_shared<CoroutineMove>(scheduler, handle);
+            const Clock::time_point deadline = Clock::now() + timeout;
+            strategy.requestMove(position, random, MoveRequest(move));
+
+            // A strategy which answered straight away needs no timeout.
+            if (move->phase.load() == CoroutineMove::ANSWERED)
+                return false;
+            scheduler.at(deadline, move, 0, true);
+            // Once this has run, the coroutine may already be running on
+            // another thread, so nothing of it may be touched.
+            return move->phase.exchange(CoroutineMove::SUSPENDED) != CoroutineMove::ANSWERED;
+        }
+
+        Answer await_resume() const { return move->result; }
+    };
+
+    /**
+     * A match coroutine, which starts suspended, is started by posting it
+     * to the pool, and frees itself when it is over.
+    **/
+    struct MatchTask
+    {
+        struct promise_type
+        {
+            MatchTask get_return_object()
+            {
+                return MatchTask{ std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    MatchTask playCoroutine(Scheduler &scheduler, const Strategy *x, const Strategy *o, MoveTime timeout,
+                            Random random, Match &match, Finish &finish)
+    {
+        Piezas game;
+        bool over = false;
+        while (!over) {
+            const Strategy &player = (game.currentTurn() == X) ? *x : *o;
+            const Answer answer = co_await MoveAwaiter{ scheduler, player, game, random.next(), timeout, nullptr };
+            over = playAnswer(game, match, answer);
+        }
+        finish.matchOver();
+    }
+
+    /**
+     * A move a match thread waits for.
+    **/
+    struct ThreadMove : MoveRequest::Pending
+    {
+        std::mutex lock;
+        std::condition_variable answered;
+        Clock::time_point deadline;
+        bool done;
+        int column;
+
+        explicit ThreadMove(Clock::time_point deadline) : deadline(deadline), done(false), column(0) {}
+
+        // The answering thread itself waits out the delay.
+        void answer(int column, MoveTime after)
+        {
+            if (after > MoveTime(0))
+                std::this_thread::sleep_for(after);
+            std::lock_guard<std::mutex> guard(lock);
+            if (done || Clock::now() > deadline)
+                return;
+            done = true;
+            this->column = column;
+            answered.notify_one();
+        }
+
+        Answer wait()
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            const bool in_time = answered.wait_until(guard, deadline, [this] { return done; });
+            done = true;
+            const Answer result = { column, !in_time };
+            return result;
+        }
+    };
+
+    void playThread(const Strategy *x, const Strategy *o, MoveTime timeout, Random random, Match &match)
+    {
+        Piezas game;
+        bool over = false;
+        while (!over) {
+            const Strategy &player = (game.currentTurn() == X) ? *x : *o;
+            const std::shared_ptr<ThreadMove> move = std::make_shared<ThreadMove>(Clock::now() + timeout);
+            player.requestMove(game, random.next(), MoveRequest(move));
+            over = playAnswer(game, match, move->wait());
+        }
+    }
+}
+
+void PolicyStrategy::requestMove(const Piezas &position, std::uint64_t random, MoveRequest request) const
+{
+    int column = below(random, BOARD_COLS);
+    if (policy == SelfPlay::AVOID_FULL) {
+        int open_columns[BOARD_COLS];
+        int open_count = 0;
+        for (int c = 0; c < BOARD_COLS; ++c) {
+            if (position.pieceAt(BOARD_ROWS - 1, c) == Blank)
+                open_columns[open_count++] = c;
+        }
+        if (open_count > 0)
+            column = open_columns[below(random, open_count)];
+    }
+    request.answer(column, thinking);
+}
+
+const int Tournament::MAX_MOVES;
+
+/**
+ * Constructor sets up a tournament which runs its coroutines on the
+ * given number of threads, or one per core if "threads" is not
+ * positive, and gives every move "moveTimeout".
+**/
+Tournament::Tournament(int threads, MoveTime moveTimeout)
+    : threads(threads > 0 ? threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))),
+      moveTimeout(moveTimeout)
+{
+}
+
+/**
+ * Enters a strategy, which has to outlive the tournament.
+**/
+void Tournament::add(const std::string &name, const Strategy &strategy)
+{
+    const Entrant entrant = { name, &strategy };
+    entrants.push_back(entrant);
+}
+
+/**
+ * Returns the number of matches a run of "rounds" rounds plays.
+**/
+std::int64_t Tournament::matchCount(int rounds) const
+{
+    const std::int64_t n = static_cast<std::int64_t>(entrants.size());
+    return std::max(0, rounds) * n * (n - 1);
+}
+
+/**
+ * Plays "rounds" rounds and returns the standings.
+**/
+Tournament::Result Tournament::play(int rounds, std::uint64_t seed, Runner runner) const
+{
+    std::vector<Match> matches;
+    matches.reserve(static_cast<std::size_t>(matchCount(rounds)));
+    for (int round = 0; round < rounds; ++round) {
+        for (std::size_t x = 0; x < entrants.size(); ++x) {
+            for (std::size_t o = 0; o < entrants.size(); ++o) {
+                if (x == o)
+                    continue;
+                const Match match = { static_cast<int>(x), static_cast<int>(o), Blank, false, 0 };
+                matches.push_back(match);
+            }
+        }
+    }
+
+    Result result;
+    const Clock::time_point start = Clock::now();
+    if (runner == COROUTINES) {
+        // The scheduler joins its workers when it goes out of scope, which
+        // has to happen while "finish" is still there for them.
+        Finish finish(static_cast<std::int64_t>(matches.size()));
+        Scheduler scheduler(threads);
+        for (std::size_t i = 0; i < matches.size(); ++i) {
+            Match &match = matches[i];
+            scheduler.post(playCoroutine(scheduler, entrants[match.x].strategy, entrants[match.o].strategy,
+                                         moveTimeout, Random(seed, i), match, finish).handle);
+        }
+        if (!matches.empty())
+            finish.wait();
+        result.threads = threads;
+    } else {
+        std::vector<std::thread> match_threads;
+        match_threads.reserve(matches.size());
+        for (std::size_t i = 0; i < matches.size(); ++i) {
+            Match &match = matches[i];
+            match_threads.emplace_back(playThread, entrants[match.x].strategy, entrants[match.o].strategy,
+                                       moveTimeout, Random(seed, i), std::ref(match));
+        }
+        for (std::thread &thread : match_threads) {
+            thread.join();
+        }
+        result.threads = static_cast<int>(match_threads.size());
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (const Entrant &entrant : entrants) {
+        const Standing standing = { entrant.name, 0, 0, 0, 0, 0 };
+        result.standings.push_back(standing);
+    }
+    result.matches = static_cast<std::int64_t>(matches.size());
+    result.moves = 0;
+    for (const Match &match : matches) {
+        Standing &x = result.standings[match.x];
+        Standing &o = result.standings[match.o];
+        ++x.played;
+        ++o.played;
+        result.moves += match.moves;
+        if (match.winner == Blank) {
+            ++x.ties;
+            ++o.ties;
+        } else {
+            Standing &winner = (match.winner == X) ? x : o;
+            Standing &loser = (match.winner == X) ? o : x;
+            ++winner.wins;
+            ++loser.losses;
+            if (match.lostOnTime)
+                ++loser.timeouts;
+        }
+    }
+    std::stable_sort(result.standings.begin(), result.standings.end(), [](const Standing &a, const Standing &b) {
+        if (a.points() != b.points())
+            return a.points() > b.points();
+        if (a.wins != b.wins)
+            return a.wins > b.wins;
+        return a.name < b.name;
+    });
+    return result;
+}
@@ -0,0 +1,167 @@
+#ifndef _TOURNAMENT_H_
+#define _TOURNAMENT_H_
+#include "Piezas.h"
+#include "SelfPlay.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef std::chrono::microseconds MoveTime;
+
+/**
+ * The move a Strategy was asked for. The strategy answers it once, at once
+ * or later and from any thread; the answer is ignored if the move has timed
+ * out by then.
+**/
+class MoveRequest
+{
+  public:
+  	/**
+  	 * What a runner waits on for an answer.
+  	**/
+  	struct Pending
+  	{
+  	  	virtual ~Pending() {}
+  	  	virtual void answer(int column, MoveTime after) = 0;
+  	};
+
+  	explicit MoveRequest(const std::shared_ptr<Pending> &pending) : pending(pending) {}
+
+  	/**
+  	 * Answers with "column", after "after" has passed. A delayed answer
+  	 * does not hold up the caller.
+  	**/
+  	void answer(int column, MoveTime after = MoveTime(0)) const { pending->answer(column, after); }
+
+  private:
+  	std::shared_ptr<Pending> pending;
+};
+
+/**
+ * A player of a Tournament. One strategy may be asked for moves of many
+ * matches at the same time, from any thread.
+**/
+class Strategy
+{
+  public:
+  	virtual ~Strategy() {}
+
+  	/**
+  	 * Asks for the move of the player whose turn it is in "position".
+  	 * "random" is a random number drawn for this move, the same on every
+  	 * run with the same seed. "position" is only good during the call.
+  	**/
+  	virtual void requestMove(const Piezas &position, std::uint64_t random, MoveRequest request) const = 0;
+};
+
+/**
+ * A Strategy which picks its column by a SelfPlay policy and answers after
+ * "thinking", standing in for a bot which takes that long.
+**/
+class PolicyStrategy : public Strategy
+{
+  public:
+  	explicit PolicyStrategy(SelfPlay::Policy policy, MoveTime thinking = MoveTime(0))
+  	  	: policy(policy), thinking(thinking)
+  	{
+  	}
+
+  	void requestMove(const Piezas &position, std::uint64_t random, MoveRequest request) const;
+
+  private:
+  	SelfPlay::Policy policy;
+  	MoveTime thinking;
+};
+
+/**
+ * A round robin between strategies: every entrant plays every other, as X
+ * and as O, in every round.
+ *
+ * With COROUTINES, every match is a C++20 coroutine which co_awaits each
+ * move from its strategy and plays it with dropPiece and gameState, and all
+ * of the matches are started at once on a small pool of threads. A match
+ * waiting for a move holds no thread: the answer, or the timeout, puts it
+ * back on the pool. Delayed answers and timeouts are kept by one timer
+ * thread. With THREAD_PER_MATCH, every match gets a thread of its own,
+ * which waits for each answer, for comparison.
+ *
+ * A player whose answer does not come within the move timeout loses the
+ * match on time. A match which is not over after MAX_MOVES moves is a tie.
+ * Both runners give the same standings for the same seed, unless moves
+ * time out.
+**/
+class Tournament
+{
+  public:
+  	enum Runner
+  	{
+  	  	COROUTINES,
+  	  	THREAD_PER_MATCH
+  	};
+
+  	static const int MAX_MOVES = 8 * BOARD_ROWS * BOARD_COLS;
+
+  	struct Standing
+  	{
+  	  	std::string name;
+  	  	int played;
+  	  	int wins;
+  	  	int losses;
+  	  	int ties;
+  	  	// Matches lost on time.
+  	  	int timeouts;
+
+  	  	// Two points for a win and one for a tie.
+  	  	int points() const { return 2 * wins + ties; }
+  	};
+
+  	struct Result
+  	{
+  	  	// Best first: by points, then by wins, then by name.
+  	  	std::vector<Standing> standings;
+  	  	std::int64_t matches;
+  	  	std::int64_t moves;
+  	  	// How long the matches took, and on how many threads.
+  	  	double seconds;
+  	  	int threads;
+
+  	  	double matchesPerSecond() const { return seconds > 0 ? matches / seconds : 0; }
+  	};
+
+  	/**
+  	 * Constructor sets up a tournament which runs its coroutines on the
+  	 * given number of threads, or one per core if "threads" is not
+  	 * positive, and gives every move "moveTimeout".
+  	**/
+  	explicit Tournament(int threads = 0, MoveTime moveTimeout = MoveTime(100000));
+
+  	/**
+  	 * Enters a strategy, which has to outlive the tournament.
+  	**/
+  	void add(const std::string &name, const Strategy &strategy);
+
+  	/**
+  	 * Returns the number of matches a run of "rounds" rounds plays.
+  	**/
+  	std::int64_t matchCount(int rounds) const;
+
+  	/**
+  	 * Plays "rounds" rounds and returns the standings.
+  	**/
+  	Result play(int rounds, std::uint64_t seed, Runner runner = COROUTINES) const;
+
+  private:
+  	struct Entrant
+  	{
+  	  	std::string name;
+  	  	const Strategy *strategy;
+  	};
+
+  	int threads;
+  	MoveTime moveTimeout;
+  	std::vector<Entrant> entrants;
+};
+
+#endif /*_TOURNAMENT_H_*/
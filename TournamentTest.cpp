@@ -0,0 +1,173 @@
+/**
+ * Unit Tests for Tournament
+**/
+
+#include <gtest/gtest.h>
+#include "Tournament.h"
+#include <atomic>
+#include <thread>
+
+namespace
+{
+    /**
+     * Answers every move from a thread of its own, the way a bot in another
+     * process would.
+    **/
+    class ThreadedStrategy : public Strategy
+    {
+      public:
+        void requestMove(const Piezas &, std::uint64_t random, MoveRequest request) const
+        {
+            ++asked;
+            std::thread([random, request] { request.answer(static_cast<int>(random % BOARD_COLS)); }).detach();
+        }
+
+        mutable std::atomic<int> asked{0};
+    };
+
+    /**
+     * Answers every move from a thread of its own after the move has timed
+     * out, and with a delay on top, the way a bot which fell behind would.
+    **/
+    class LateStrategy : public Strategy
+    {
+      public:
+        void requestMove(const Piezas &, std::uint64_t random, MoveRequest request) const
+        {
+            ++asked;
+            std::thread([this, random, request] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                request.answer(static_cast<int>(random % BOARD_COLS), MoveTime(5000));
+                ++answered;
+            }).detach();
+        }
+
+        mutable std::atomic<int> asked{0};
+        mutable std::atomic<int> answered{0};
+    };
+
+    /**
+     * Never answers.
+    **/
+    class SilentStrategy : public Strategy
+    {
+      public:
+        void requestMove(const Piezas &, std::uint64_t, MoveRequest) const {}
+    };
+
+    int totalPlayed(const Tournament::Result &result)
+    {
+        int played = 0;
+        for (const Tournament::Standing &standing : result.standings) {
+            played += standing.played;
+        }
+        return played;
+    }
+}
+
+
+TEST(TournamentTest, runners_agree)
+{
+    // This test plays the same round robin with coroutines and with a thread per match
+    // and checks that the standings are the same.
+    const PolicyStrategy random_player(SelfPlay::RANDOM);
+    const PolicyStrategy careful_player(SelfPlay::AVOID_FULL);
+    const PolicyStrategy slow_player(SelfPlay::AVOID_FULL, MoveTime(200));
+    Tournament tournament(2);
+    tournament.add("random", random_player);
+    tournament.add("careful", careful_player);
+    tournament.add("slow", slow_player);
+    ASSERT_EQ(tournament.matchCount(20), 120);
+
+    const Tournament::Result coroutines = tournament.play(20, 3, Tournament::COROUTINES);
+    const Tournament::Result threads = tournament.play(20, 3, Tournament::THREAD_PER_MATCH);
+    ASSERT_EQ(coroutines.matches, 120);
+    ASSERT_EQ(coroutines.threads, 2);
+    ASSERT_EQ(threads.threads, 120);
+    ASSERT_EQ(totalPlayed(coroutines), 240);
+    ASSERT_EQ(coroutines.moves, threads.moves);
+    ASSERT_EQ(coroutines.standings.size(), 3u);
+    for (std::size_t i = 0; i < coroutines.standings.size(); ++i) {
+        const Tournament::Standing &a = coroutines.standings[i];
+        const Tournament::Standing &b = threads.standings[i];
+        ASSERT_EQ(a.name, b.name);
+        ASSERT_EQ(a.played, 80);
+        ASSERT_EQ(a.wins, b.wins);
+        ASSERT_EQ(a.losses, b.losses);
+        ASSERT_EQ(a.ties, b.ties);
+        ASSERT_EQ(a.timeouts, 0);
+        if (i > 0) {
+            ASSERT_GE(coroutines.standings[i - 1].points(), a.points());
+        }
+    }
+}
+
+
+TEST(TournamentTest, answers_from_other_threads)
+{
+    // This test has one strategy answer every move from another thread, and checks that
+    // every match it plays finishes in time.
+    const ThreadedStrategy threaded;
+    const PolicyStrategy careful_player(SelfPlay::AVOID_FULL);
+    Tournament tournament(2, MoveTime(2000000));
+    tournament.add("threaded", threaded);
+    tournament.add("careful", careful_player);
+
+    const Tournament::Result result = tournament.play(50, 9);
+    ASSERT_EQ(result.matches, 100);
+    ASSERT_GE(threaded.asked.load(), 100);
+    for (const Tournament::Standing &standing : result.standings) {
+        ASSERT_EQ(standing.played, 100);
+        ASSERT_EQ(standing.wins + standing.losses + standing.ties, 100);
+        ASSERT_EQ(standing.timeouts, 0);
+    }
+}
+
+
+TEST(TournamentTest, late_answers_after_play_returns)
+{
+    // This test has one strategy answer every move from another thread, with a delay,
+    // only after the move has timed out, and checks that it loses every match on time
+    // and that play does not return before every late answer has been dealt with.
+    const LateStrategy late;
+    const PolicyStrategy careful_player(SelfPlay::AVOID_FULL);
+    Tournament tournament(2, MoveTime(2000));
+    tournament.add("late", late);
+    tournament.add("careful", careful_player);
+
+    const Tournament::Result result = tournament.play(2, 4);
+    ASSERT_EQ(late.answered.load(), late.asked.load());
+    ASSERT_EQ(late.asked.load(), 4);
+    ASSERT_EQ(result.standings[0].name, "careful");
+    ASSERT_EQ(result.standings[0].wins, 4);
+    ASSERT_EQ(result.standings[1].timeouts, 4);
+}
+
+
+TEST(TournamentTest, slow_players_lose_on_time)
+{
+    // This test gives every move 2 ms and checks that a player which never answers and
+    // one which takes 50 ms lose all their matches against a player which answers at
+    // once, on time. Between the two of them X runs out of time first, so each wins
+    // its 3 matches as O. Only the prompt player's first moves as X are ever played.
+    const SilentStrategy silent;
+    const PolicyStrategy slow_player(SelfPlay::AVOID_FULL, MoveTime(50000));
+    const PolicyStrategy careful_player(SelfPlay::AVOID_FULL);
+    Tournament tournament(1, MoveTime(2000));
+    tournament.add("silent", silent);
+    tournament.add("slow", slow_player);
+    tournament.add("careful", careful_player);
+
+    for (int runner = Tournament::COROUTINES; runner <= Tournament::THREAD_PER_MATCH; ++runner) {
+        const Tournament::Result result = tournament.play(3, 1, static_cast<Tournament::Runner>(runner));
+        ASSERT_EQ(result.standings[0].name, "careful");
+        ASSERT_EQ(result.standings[0].wins, 12);
+        for (int i = 1; i < 3; ++i) {
+            const Tournament::Standing &loser = result.standings[i];
+            ASSERT_EQ(loser.wins, 3);
+            ASSERT_EQ(loser.losses, 9);
+            ASSERT_EQ(loser.timeouts, 9);
+        }
+        ASSERT_EQ(result.moves, 6);
+    }
+}